@@ -36,6 +36,8 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #define Octree_h
 
 #include <assert.h>
+#include <vector>
+#include <stdint.h>
 
 #define COMPUTE_SIDE(i, bit, p, mid, newMin, newMax) \
 if (p >= mid)         \
@@ -49,6 +51,11 @@ else                  \
 }
 
 
+/// SEB CUSTOM MODIFICATIONS: Node arena
+// Nodes live in one contiguous array and refer to their children by index. clear() only resets the node count,
+// so rebuilding the tree every frame reuses the nodes (and their data) instead of allocating and freeing each one.
+// Reused node data is emptied with its clear() member if it has one (so e.g. vectors keep their capacity), otherwise it is reassigned N().
+// NOTE: References returned by getCell are only valid until the next node is created.
 template <class N>
 class Octree
 {
@@ -74,33 +81,36 @@ protected:
     struct OctreeNode
     {
         N _nodeData;
-        OctreeNode* _children[8];
-        OctreeNode()
-        {
-            for (int i = 0; i < 8; i++)
-                _children[i] = 0;
-        }
-        virtual ~OctreeNode()
-        {
-            for (int i = 0; i < 8; i++)
-                if (_children[i])
-                    delete _children[i];
-        }
+        int _children[8];       // Indices into _nodes, -1 if the child hasn't been created
+    };
+    
+    struct StackEntry
+    {
+        int node;
+        int depth;
+        Point min;
+        Point max;
+        StackEntry(int in_node, const Point& in_min, const Point& in_max, int in_depth = 0): node(in_node), depth(in_depth), min(in_min), max(in_max) {}
     };
     
     Point _min;
     Point _max;
     Point _cellSize;
-    OctreeNode* _root;
+    std::vector<OctreeNode> _nodes;     // Node 0 is the root, nodes past _nodeCount are left from earlier builds for reuse
+    size_t _nodeCount;
+    std::vector<StackEntry> _parts;     // Subtrees split between threads by visitLeavesParallel
     
 public:
-    Octree(float min[3], float max[3], float cellSize[3]): _min(min), _max(max), _cellSize(cellSize), _root(0) {}
-    virtual ~Octree() { delete _root; }
+    Octree(float min[3], float max[3], float cellSize[3]): _min(min), _max(max), _cellSize(cellSize), _nodeCount(0) {}
+    virtual ~Octree() {}
     
 	/// SEB CUSTOM MODIFICATIONS: Getters
 	float* GetMin() { return &_min.x; }
 	float* GetMax() { return &_max.x; }
 
+	size_t GetNodeCount() const { return _nodeCount; }
+	size_t GetNodeCapacity() const { return _nodes.size(); }		// Nodes allocated so far, rebuilds only allocate past this
+
 	/// SEB CUSTOM MODIFICATIONS: Setters
 	void SetVolume(float a_origin[3], float a_extents[3]) {
 		Point halfExtents = Point(a_extents[0] / 2.f, a_extents[1] / 2.f, a_extents[2] / 2.f);
@@ -127,14 +137,14 @@ public:
         Point currMin(_min);
         Point currMax(_max);
         Point delta = _max - _min;
-        if (!_root)
-            _root = new OctreeNode();
-        OctreeNode* currNode = _root;
+        if (_nodeCount == 0)
+            allocateNode();
+        int currNode = 0;
         while (delta >= _cellSize)
         {
             bool shouldContinue = true;
             if (callback)
-                shouldContinue = callback->operator()(currMin, currMax, currNode->_nodeData);
+                shouldContinue = callback->operator()(currMin, currMax, _nodes[currNode]._nodeData);
             if (!shouldContinue)
                 break;
             Point mid = (delta * 0.5f) + currMin;
@@ -144,26 +154,127 @@ public:
             COMPUTE_SIDE(index, 1, ppos.x, mid.x, newMin.x, newMax.x)
             COMPUTE_SIDE(index, 2, ppos.y, mid.y, newMin.y, newMax.y)
             COMPUTE_SIDE(index, 4, ppos.z, mid.z, newMin.z, newMax.z)
-            if (!(currNode->_children[index]))
-                currNode->_children[index] = new OctreeNode();
-            currNode = currNode->_children[index];
+            currNode = getOrCreateChild(currNode, index);
             currMin = newMin;
             currMax = newMax;
             delta = currMax - currMin;
         }
-        return currNode->_nodeData;
+        return _nodes[currNode]._nodeData;
+    }
+    
+    /// SEB CUSTOM MODIFICATIONS: Bulk build
+    // Number of times getCell halves the volume, the smallest cells form a grid of 2^depth cells along each axis.
+    int getLeafDepth() const
+    {
+        Point delta = _max - _min;
+        int depth = 0;
+        while (delta >= _cellSize)
+        {
+            delta = delta * 0.5f;
+            depth++;
+        }
+        return depth;
+    }
+    
+    // Rebuilds the tree from the Morton codes of the smallest cells (grid coordinates from getLeafDepth with their bits interleaved, x lowest),
+    // only creating cells that have a key and their parents instead of searching down from the root once per object.
+    // keyAt(i) returns the i'th of count keys, which must be sorted so equal keys are next to each other.
+    // visitor(first, last, nodeData) is called once per distinct key with the range of keys [first, last) that fall in its cell, in visit order.
+    template <class KeyAt, class Visitor>
+    void buildLeaves(size_t count, KeyAt&& keyAt, Visitor&& visitor)
+    {
+        int depth = getLeafDepth();
+        assert(depth <= 21);    // Three bits a level have to fit in a 64 bit key
+        clear();
+        allocateNode();
+        int path[22];           // Nodes from the root down to the previous leaf, shared parents aren't searched for again
+        path[0] = 0;
+        uint64_t prevKey = 0;
+        size_t first = 0;
+        while (first < count)
+        {
+            uint64_t key = keyAt(first);
+            size_t last = first + 1;
+            while (last < count && keyAt(last) == key)
+                last++;
+            int level = 0;
+            if (first > 0)
+                while (level < depth && childIndex(key, depth, level) == childIndex(prevKey, depth, level))
+                    level++;
+            for (; level < depth; level++)
+                path[level + 1] = getOrCreateChild(path[level], childIndex(key, depth, level));
+            visitor(first, last, _nodes[path[depth]]._nodeData);
+            prevKey = key;
+            first = last;
+        }
     }
     
     void traverse(Callback* callback)
     {
         assert(callback);
-        traverseRecursive(callback, _min, _max, _root);
+        visit([callback](const float min[3], const float max[3], N& nodeData) { return callback->operator()(min, max, nodeData); });
+    }
+    
+    /// SEB CUSTOM MODIFICATIONS: Templated traversal
+    // Same as traverse but the visitor is inlined instead of called through a virtual, and walks the tree with an explicit stack.
+    // Visitor is any callable as bool(const float min[3], const float max[3], N& nodeData). Return value: true = continue and traverse subcells; false = abort branch.
+    template <class Visitor>
+    void visit(Visitor&& visitor)
+    {
+        if (_nodeCount == 0)
+            return;
+        std::vector<StackEntry> stack;
+        stack.push_back(StackEntry(0, _min, _max));
+        while (!stack.empty())
+        {
+            StackEntry entry = stack.back();
+            stack.pop_back();
+            if (visitor((const float*)entry.min, (const float*)entry.max, _nodes[entry.node]._nodeData))
+                pushChildren(stack, entry);
+        }
+    }
+    
+    // Only calls the visitor with leaves (cells without subcells), in the same order as visit.
+    // Return value of the visitor: true = continue; false = stop the whole traversal.
+    template <class Visitor>
+    void visitLeaves(Visitor&& visitor)
+    {
+        if (_nodeCount == 0)
+            return;
+        visitLeavesFrom(StackEntry(0, _min, _max), visitor);
+    }
+    
+    // Splits the tree into the subtrees at splitDepth (plus any leaves above it) and visits their leaves in parallel.
+    // parallelFor(count, job) must call job(i, extra...) once for every i in [0, count), from any thread, any extra arguments
+    // it passes are forwarded to the visitor after nodeData (e.g. a per-thread output list). Parts are numbered in visit order.
+    // Return value of the visitor: true = continue; false = stop visiting that part.
+    // NOTE: The visitor is called concurrently, only one parallel visit can run on an octree at a time.
+    template <class ParallelFor, class Visitor>
+    void visitLeavesParallel(ParallelFor&& parallelFor, Visitor&& visitor, int splitDepth = 2)
+    {
+        _parts.clear();
+        if (_nodeCount > 0)
+        {
+            std::vector<StackEntry> stack;
+            stack.push_back(StackEntry(0, _min, _max));
+            while (!stack.empty())
+            {
+                StackEntry entry = stack.back();
+                stack.pop_back();
+                if (entry.depth == splitDepth || !pushChildren(stack, entry))
+                    _parts.push_back(entry);
+            }
+        }
+        parallelFor(_parts.size(), [this, &visitor](size_t part, auto&&... extra) {
+            visitLeavesFrom(_parts[part], [&](const float min[3], const float max[3], N& nodeData) {
+                return visitor(min, max, nodeData, extra...);
+            });
+        });
     }
     
     void clear()
     {
-        delete _root;
-        _root = NULL;
+        _nodeCount = 0;
     }
     
     class Iterator
@@ -171,50 +282,107 @@ public:
     public:
         Iterator getChild(int i)
         {
-            return Iterator(_currNode->_children[i]);
+            return Iterator(_octree, _currNode >= 0 ? _octree->_nodes[_currNode]._children[i] : -1);
         }
         N* getData()
         {
-            if (_currNode)
-                return &_currNode->_nodeData;
+            if (_currNode >= 0)
+                return &_octree->_nodes[_currNode]._nodeData;
             else return NULL;
         }
     protected:
-        OctreeNode* _currNode;
-        Iterator(OctreeNode* node): _currNode(node) {}
+        Octree* _octree;
+        int _currNode;
+        Iterator(Octree* octree, int node): _octree(octree), _currNode(node) {}
         friend class Octree;
     };
     
     Iterator getIterator()
     {
-        return Iterator(_root);
+        return Iterator(this, _nodeCount > 0 ? 0 : -1);
     }
     
 protected:
-    void traverseRecursive(Callback* callback, const Point& currMin, const Point& currMax, OctreeNode* currNode)
+    /// SEB CUSTOM MODIFICATIONS: Node arena
+    // Picks the reset for reused node data, clear() if N has one.
+    template <class T>
+    static auto resetNodeData(T& nodeData, int) -> decltype(nodeData.clear(), void())
     {
-        if (!currNode)
-            return;
-        bool shouldContinue = callback->operator()(currMin, currMax, currNode->_nodeData);
-        if (!shouldContinue)
-            return;
-        Point delta = currMax - currMin;
-        Point mid = (delta * 0.5f) + currMin;
-        traverseRecursive(callback, currMin, mid, currNode->_children[0]);
-        traverseRecursive(callback, Point(mid.x, currMin.y, currMin.z), 
-                                    Point(currMax.x, mid.y, mid.z), currNode->_children[1]);
-        traverseRecursive(callback, Point(currMin.x, mid.y, currMin.z), 
-                                    Point(mid.x, currMax.y, mid.z), currNode->_children[2]);
-        traverseRecursive(callback, Point(mid.x, mid.y, currMin.z), 
-                                    Point(currMax.x, currMax.y, mid.z), currNode->_children[3]);
-        traverseRecursive(callback, Point(currMin.x, currMin.y, mid.z), 
-                                    Point(mid.x, mid.y, currMax.z), currNode->_children[4]);
-        traverseRecursive(callback, Point(mid.x, currMin.y, mid.z), 
-                                    Point(currMax.x, mid.y, currMax.z), currNode->_children[5]);
-        traverseRecursive(callback, Point(currMin.x, mid.y, mid.z), 
-                                    Point(mid.x, currMax.y, currMax.z), currNode->_children[6]);
-        traverseRecursive(callback, mid, currMax, currNode->_children[7]);
-    }    
+        nodeData.clear();
+    }
+    template <class T>
+    static void resetNodeData(T& nodeData, long)
+    {
+        nodeData = T();
+    }
+    
+    int allocateNode()
+    {
+        if (_nodeCount == _nodes.size())
+            _nodes.push_back(OctreeNode());
+        else
+            resetNodeData(_nodes[_nodeCount]._nodeData, 0);
+        OctreeNode& node = _nodes[_nodeCount];
+        for (int i = 0; i < 8; i++)
+            node._children[i] = -1;
+        return (int)_nodeCount++;
+    }
+    
+    int getOrCreateChild(int node, int i)
+    {
+        int child = _nodes[node]._children[i];
+        if (child < 0)
+        {
+            // Creating the child can grow _nodes, so look the parent up again afterwards
+            child = allocateNode();
+            _nodes[node]._children[i] = child;
+        }
+        return child;
+    }
+    
+    /// SEB CUSTOM MODIFICATIONS: Bulk build
+    // Which child a key's cell is under at a level below the root, matches getCell's index (x = 1, y = 2, z = 4).
+    static int childIndex(uint64_t key, int depth, int level)
+    {
+        return (int)((key >> (3 * (depth - level - 1))) & 7);
+    }
+    
+    /// SEB CUSTOM MODIFICATIONS: Templated traversal
+    // Pushes the node's existing children so they pop in index order, returns false if it has none (a leaf).
+    bool pushChildren(std::vector<StackEntry>& stack, const StackEntry& entry) const
+    {
+        const int* children = _nodes[entry.node]._children;
+        Point mid = ((entry.max - entry.min) * 0.5f) + entry.min;
+        bool hasChildren = false;
+        for (int i = 7; i >= 0; i--)
+        {
+            if (children[i] < 0)
+                continue;
+            Point newMin(entry.min);
+            Point newMax(entry.max);
+            if (i & 1) newMin.x = mid.x; else newMax.x = mid.x;
+            if (i & 2) newMin.y = mid.y; else newMax.y = mid.y;
+            if (i & 4) newMin.z = mid.z; else newMax.z = mid.z;
+            stack.push_back(StackEntry(children[i], newMin, newMax, entry.depth + 1));
+            hasChildren = true;
+        }
+        return hasChildren;
+    }
+    
+    template <class Visitor>
+    bool visitLeavesFrom(const StackEntry& root, Visitor&& visitor)
+    {
+        std::vector<StackEntry> stack;
+        stack.push_back(root);
+        while (!stack.empty())
+        {
+            StackEntry entry = stack.back();
+            stack.pop_back();
+            if (!pushChildren(stack, entry) && !visitor((const float*)entry.min, (const float*)entry.max, _nodes[entry.node]._nodeData))
+                return false;
+        }
+        return true;
+    }
 };
 
 #endif
@@ -8,6 +8,7 @@ namespace Physebs {
 	class Scene;
 }
 class Camera;
+class GizmosDebugDraw;
 
 class _2018_03_04_PhysicsEngineDemonstrationApp : public aie::Application {
 public:
@@ -31,5 +32,6 @@ protected:
 
 	// Physics
 	Physebs::Scene*		m_scene = nullptr;
+	GizmosDebugDraw*	m_debugDraw = nullptr;
 
 };
\ No newline at end of file
@@ -8,6 +8,7 @@
 #include "Physics\Scene.h"
 #include "Physics\AABB.h"
 #include "Camera\Camera.h"
+#include "GizmosDebugDraw.h"
 #include "Physics\Spring.h"
 #include "PhysebsUtility_Funcs.h"
 #include "tinyxml2/tinyxml2.h"
@@ -42,8 +43,10 @@ bool _2018_03_04_PhysicsEngineDemonstrationApp::startup() {
 
 	// Make a scene (ha-ha)
 	m_scene = new Scene();
+	m_debugDraw = new GizmosDebugDraw();
+	m_scene->SetDebugDraw(m_debugDraw);
 	m_scene->SetGlobalForce(glm::vec3(0.f, 0, 0));
-	*m_scene->GetIsPartitionedRef() = false;
+	m_scene->SetBroadphase(BRUTE_FORCE);
 
 	m_scene->LoadScene("./default.scene");
 
@@ -57,6 +60,7 @@ void _2018_03_04_PhysicsEngineDemonstrationApp::shutdown() {
 
 	delete m_camera;
 	delete m_scene;
+	delete m_debugDraw;
 
 	Gizmos::destroy();
 }
@@ -153,11 +157,16 @@ void _2018_03_04_PhysicsEngineDemonstrationApp::update(float deltaTime) {
 	static float	minCellSize[3] = MIN_VOLUME_SIZE;
 
 	ImGui::SliderFloat("Fixed Time Step", m_scene->GetTimeStepRef(), 0.001f, 1.f);
+	ImGui::SliderInt("Solver Iterations", m_scene->GetSolverIterationsRef(), 1, 32);
 
-	ImGui::Checkbox("Use Octal Space Partitioning", m_scene->GetIsPartitionedRef());
+	// Items must be in the same order as eBroadphase
+	ImGui::Combo("Broadphase", m_scene->GetBroadphaseRef(), "Brute Force\0Octree\0Loose Octree\0Sweep And Prune\0Spatial Hash\0AABB Tree\0\0");
+	ImGui::Checkbox("Auto Select Broadphase", m_scene->GetIsAutoBroadphaseRef());
+	ImGui::Text("Broadphase Time: %.3fms", m_scene->GetBroadphaseTime(m_scene->GetBroadphase()));
+	ImGui::Checkbox("Sleep Resting Objects", m_scene->GetAllowSleepRef());
 
-	// Simulation is using partitioning, show partition options
-	if (*(m_scene->GetIsPartitionedRef())) {		// De-reference to get bool
+	// Simulation is using the octree, show partition options
+	if (m_scene->GetBroadphase() == OCTREE) {
 
 		ImGui::InputFloat3("Simulation Origin", simulationOrigin, 2);
 		ImGui::InputFloat3("Simulation Size", simulationExtents, 2);
@@ -227,7 +236,7 @@ void _2018_03_04_PhysicsEngineDemonstrationApp::update(float deltaTime) {
 			if (ImGui::SmallButton("Spawn Sphere")) {
 				glm::vec2 currentDim = glm::vec2(dim[0], dim[1]);
 
-				m_scene->AddObject(new Sphere(radius, currentDim, currentPos, mass, friction, b_dynamic, currentColor, restitution));
+				m_scene->CreateObject<Sphere>(radius, currentDim, currentPos, mass, friction, b_dynamic, currentColor, restitution);
 				b_createdObj = true;
 			}
 		}
@@ -247,7 +256,7 @@ void _2018_03_04_PhysicsEngineDemonstrationApp::update(float deltaTime) {
 				glm::vec3 currentNormal = glm::vec3(normal[0], normal[1], normal[2]);
 				glm::vec3 currentPlanePos = currentNormal * dist;					// Ignore user input for position and create it from normal and distance
 
-				m_scene->AddObject(new Plane(currentNormal, dist, currentPlanePos, mass, friction, b_dynamic, currentColor, restitution));
+				m_scene->CreateObject<Plane>(currentNormal, dist, currentPlanePos, mass, friction, b_dynamic, currentColor, restitution);
 				b_createdObj = true;
 			}
 		}
@@ -266,7 +275,7 @@ void _2018_03_04_PhysicsEngineDemonstrationApp::update(float deltaTime) {
 			aie::Gizmos::addAABB(currentPos, currentExtents / 2.f, currentColor);		// Bootstrap treats AABB extents as half extents
 
 			if (ImGui::SmallButton("Spawn AABB")) {
-				m_scene->AddObject(new AABB(currentExtents, currentPos, mass, friction, b_dynamic, currentColor, restitution));
+				m_scene->CreateObject<AABB>(currentExtents, currentPos, mass, friction, b_dynamic, currentColor, restitution);
 				b_createdObj = true;
 			}
 		}
@@ -308,7 +317,10 @@ void _2018_03_04_PhysicsEngineDemonstrationApp::update(float deltaTime) {
 			ImGui::Text("Universal Rigidbody Variables");
 
 			ImGui::InputFloat3("Current Position", currentObj->GetPosRef(), 2);
-			ImGui::InputFloat("Current Mass", currentObj->GetMassRef(), 1.f, 0.f, 2);
+			float currentMass = currentObj->GetMass();
+			if (ImGui::InputFloat("Current Mass", &currentMass, 1.f, 0.f, 2)) {
+				currentObj->SetMass(currentMass);
+			}
 			ImGui::InputFloat("Current Friction", currentObj->GetFrictRef(), 1.f, 0.f, 2);
 			ImGui::InputFloat("Current Restitution", currentObj->GetRestitutionRef(), 1.f, 0.f, 2);
 			ImGui::ColorEdit4("Current Color", currentObj->GetColorRef());
@@ -370,11 +382,8 @@ void _2018_03_04_PhysicsEngineDemonstrationApp::update(float deltaTime) {
 
 			// User wants to delete selected object
 			if (ImGui::Button("Delete Object")) {
-				// Remove from scene (NOTE: DOES NOT DELETE THE MEMORY)
-				m_scene->RemoveObject(currentObj);
-
-				// Delete object allocated memory
-				delete currentObj;
+				// Remove from scene and free it back into its pool (also destroys any attached constraints)
+				m_scene->DestroyObject(currentObj);
 			}
 
 		}
@@ -533,7 +542,7 @@ void _2018_03_04_PhysicsEngineDemonstrationApp::update(float deltaTime) {
 
 				// User wants to create spring
 				if (ImGui::SmallButton("Attach Spring")) {
-					m_scene->AddConstraint(new Spring(selectedActor, selectedOther, currentColor, springiness, restLength, dampening));
+					m_scene->CreateConstraint<Spring>(selectedActor, selectedOther, currentColor, springiness, restLength, dampening);
 				}
 			}
 		}
@@ -613,10 +622,8 @@ void _2018_03_04_PhysicsEngineDemonstrationApp::update(float deltaTime) {
 
 			// User wants to remove constraint from scene
 			if (ImGui::SmallButton("Delete Constraint")) {
-				m_scene->RemoveConstraint(currentConstraint);
-
-				// Delete dynamically allocated memory to avoid memory leaks
-				delete currentConstraint;
+				// Remove from scene and free it back into its pool
+				m_scene->DestroyConstraint(currentConstraint);
 			}
 		}
 	}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include "Physics/DebugDraw.h"
+#include <Gizmos.h>
+
+/**
+*	@brief Debug draw sink that forwards the physics scene's debug geometry to bootstrap Gizmos.
+*/
+class GizmosDebugDraw : public Physebs::DebugDraw {
+public:
+	virtual void AddAABB(const glm::vec3& a_center, const glm::vec3& a_halfExtents, const glm::vec4& a_color) {
+		aie::Gizmos::addAABB(a_center, a_halfExtents, a_color);
+	}
+
+	virtual void AddAABBFilled(const glm::vec3& a_center, const glm::vec3& a_halfExtents, const glm::vec4& a_color) {
+		aie::Gizmos::addAABBFilled(a_center, a_halfExtents, a_color);
+	}
+
+	virtual void AddSphere(const glm::vec3& a_center, float a_radius, int a_rows, int a_columns, const glm::vec4& a_color) {
+		aie::Gizmos::addSphere(a_center, a_radius, a_rows, a_columns, a_color);
+	}
+
+	virtual void AddLine(const glm::vec3& a_start, const glm::vec3& a_end, const glm::vec4& a_color) {
+		aie::Gizmos::addLine(a_start, a_end, a_color);
+	}
+
+	virtual void AddTri(const glm::vec3& a_v0, const glm::vec3& a_v1, const glm::vec3& a_v2, const glm::vec4& a_color) {
+		aie::Gizmos::addTri(a_v0, a_v1, a_v2, a_color);
+	}
+};
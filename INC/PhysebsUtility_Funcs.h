@@ -4,7 +4,7 @@
 #include <sstream>
 #include <glm/vec3.hpp>
 #include <glm/vec4.hpp>
-#include "tinyxml2\tinyxml2.h"
+#include "tinyxml2/tinyxml2.h"
 
 namespace Physebs {
 	/**
@@ -8,6 +8,14 @@
 
 #define DEFAULT_TIME_STEP 0.01f			// Frame = one hundredth of a second/100fps
 
+#define DEFAULT_THREAD_COUNT 1			// Threads a scene steps with, 1 = single-threaded, 0 = one per hardware core
+#define JOB_GRAIN_SIZE 1024				// Items per chunk when splitting per-body loops across threads
+#define PAIR_GRAIN_SIZE 256				// Items per chunk when splitting broadphase queries and narrowphase pair checks across threads
+#define SOLVER_GRAIN_SIZE 128			// Contacts or constraints per chunk when splitting a solver batch across threads, batches this small run on the calling thread
+#define SORT_GRAIN_SIZE 8192			// Items per chunk when radix sorting across threads, each chunk keeps its own digit counts
+
+#define POOL_SLAB_SIZE 256				// Objects per slab of the scene's object and constraint pools
+
 #define DEFAULT_MASS 2.f
 #define DEFAULT_FRICTION 1.f
 #define DEFAULT_RESTITUTION 1.0f
@@ -20,6 +28,32 @@
 
 #define MIN_VOLUME_SIZE { 100, 100, 100}
 
+#define LOOSE_OCTREE_LOOSENESS 2.f			// Loose bounds of a cell are its half size scaled by this
+#define LOOSE_OCTREE_SPLIT_THRESHOLD 16		// Objects a cell can hold before it gets subdivided
+#define LOOSE_OCTREE_MAX_DEPTH 8			// Cells at this depth are never subdivided
+
+#define SPATIAL_HASH_CELL_SIZE 8.f			// Size of the spatial hash grid cells, around the size of the largest common object works best
+#define SPATIAL_HASH_MAX_OBJECT_CELLS 64	// Objects touching more cells than this are checked against every object instead of being put in the grid
+
+#define AABB_TREE_MARGIN 0.5f				// How far AABB tree leaves are fattened past their object's bounds, objects can move this far before being re-inserted
+
+#define PLANE_CULL_SLACK 0.001f			// Volumes this close to a plane still count as touching it when culling, covers rounding differences with the exact plane checks
+#define NARROWPHASE_SLACK 0.001f			// Pairs this close to touching still pass the batched narrowphase kernels, covers rounding differences with the exact checks
+
+#define SAP_AXIS 0							// Axis sweep and prune sorts along (0 = x, 1 = y, 2 = z), x suits scenes spread out over a ground plane
+
+#define DEFAULT_SOLVER_ITERATIONS 8		// Passes the contact solver makes over every contact each step
+#define RESTITUTION_THRESHOLD 1.f			// Contacts closing slower than this don't bounce, so resting objects settle instead of jittering
+#define CONTACT_SLOP 0.01f				// Overlap left in place so resting contacts stay touching between steps
+#define POSITION_CORRECTION 0.8f			// Share of the overlap past the slop pushed out each step
+
+#define SLEEP_VELOCITY 0.5f				// Bodies moving slower than this count as resting, resting contacts keep bodies jittering at around gravity * time step
+#define SLEEP_TIME 0.5f					// Seconds every body of an island has to rest for before the island goes to sleep
+
+#define BROADPHASE_AUTO_SAMPLE_STEPS 4		// Steps auto selection runs each broadphase for when comparing them, the first only catches the structure up and isn't counted
+#define BROADPHASE_AUTO_INTERVAL 500		// Steps auto selection sticks with the cheapest broadphase before comparing them all again
+#define BROADPHASE_AUTO_BRUTE_FORCE_LIMIT 512	// Auto selection doesn't try brute force with more objects than this, a single step would stall the scene
+
 #define DEFAULT_COLOR glm::vec4(0, 0, 0, 1)
 #define DEFAULT_CONSTRAINT_COLOR glm::vec4(1, 1, 0, 1)
 #define DEFAULT_SELECTION_COLOR glm::vec4(0, 1, 0, 0.5)
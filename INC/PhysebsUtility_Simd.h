@@ -0,0 +1,25 @@
+#pragma once
+
+// SSE2 is part of every x64 target, 32 bit builds need it enabled (/arch:SSE2 or -msse2), otherwise kernels fall back to plain loops
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define PHYSEBS_SSE 1
+#include <emmintrin.h>
+#else
+#define PHYSEBS_SSE 0
+#endif
+
+// AVX has to be enabled explicitly (/arch:AVX or -mavx), kernels that have an AVX version then work on twice as many floats at once
+#if defined(__AVX__)
+#define PHYSEBS_AVX 1
+#include <immintrin.h>
+#else
+#define PHYSEBS_AVX 0
+#endif
+
+#define SIMD_WIDTH 4		// Floats processed together by the kernels, lists they work on are padded to a multiple of this
+
+#if PHYSEBS_AVX
+#define PAIR_BATCH_WIDTH 8	// Pairs the narrowphase kernels check at once
+#else
+#define PAIR_BATCH_WIDTH 4
+#endif
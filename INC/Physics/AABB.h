@@ -1,8 +1,9 @@
 #pragma once
 
-#include "Physics\Rigidbody.h"
+#include "Physics/Rigidbody.h"
 #include <glm/vec2.hpp>
 #include <vector>
+#include <cmath>
 
 namespace Physebs {
 	class AABB : public Rigidbody {
@@ -14,7 +15,9 @@ namespace Physebs {
 
 		virtual ~AABB();
 
-		virtual void Draw();
+		virtual void Draw(DebugDraw* a_debugDraw);
+
+		virtual void CalculateBounds(glm::vec3& a_min, glm::vec3& a_max) const;
 
 		float*				GetExtentsRef()							{ return &m_extents.x; }
 		const glm::vec3&	GetExtents() const						{ return m_extents; }
@@ -33,6 +36,26 @@ namespace Physebs {
 				a_pt[2] > a_min[2] && a_pt[2] < a_max[2]);
 		}
 
+		/**
+		*	@brief Check if volume (defined by min and max) touches a plane, i.e. isn't entirely on one side of it.
+		*	NOTE: Volumes within PLANE_CULL_SLACK of the plane count as touching, so culling with this never drops an object the exact checks would find.
+		*	@param a_min is the minimum point of the volume.
+		*	@param a_max is the maximum point of the volume.
+		*	@param a_normal is the direction the plane is facing in.
+		*	@param a_dist is how far away from the origin the plane is.
+		*	@return TRUE: Volume touches plane | FALSE: Volume is entirely on one side of plane
+		*/
+		static bool MinMaxTouchesPlane(const glm::vec3& a_min, const glm::vec3& a_max, const glm::vec3& a_normal, float a_dist) {
+			glm::vec3 center	= (a_min + a_max) * 0.5f;
+			glm::vec3 halfSize	= (a_max - a_min) * 0.5f;
+
+			// Distance from the center to the plane against how far the volume reaches along the normal
+			float centerDist	= a_normal.x * center.x + a_normal.y * center.y + a_normal.z * center.z - a_dist;
+			float reach			= std::abs(a_normal.x) * halfSize.x + std::abs(a_normal.y) * halfSize.y + std::abs(a_normal.z) * halfSize.z;
+
+			return std::abs(centerDist) <= reach + PLANE_CULL_SLACK;
+		}
+
 		// NOTE: Do not return references because functions are returning temporary memory
 		glm::vec3	CalculateMin() const;
 		glm::vec3	CalculateMax() const;
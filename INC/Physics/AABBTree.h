@@ -0,0 +1,94 @@
+#pragma once
+
+#include <vector>
+#include <unordered_map>
+#include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
+#include "PhysebsUtility_Literals.h"
+#include "Physics/Broadphase.h"
+
+namespace Physebs {
+	class Rigidbody;
+	class DebugDraw;
+	class JobSystem;
+
+	/**
+	*	@brief Dynamic bounding volume hierarchy broadphase, every object is a leaf holding its bounds fattened by a margin.
+	*	Leaves are only re-inserted once an object escapes its fat bounds, so slow objects cost nothing to keep in the tree.
+	*	Insertion picks the sibling that grows the tree's surface area the least and the tree is kept balanced with rotations,
+	*	so it copes with objects of very different sizes (e.g. large static walls next to small spheres) without any bounds or cell size.
+	*	NOTE: Planes are infinite and are never inserted, use QueryPlane to find the objects that could be touching one.
+	*/
+	class AABBTree : public Broadphase {
+	public:
+		AABBTree(float a_margin = AABB_TREE_MARGIN);
+
+		virtual void Insert(Rigidbody* a_obj);
+		virtual void Remove(Rigidbody* a_obj);
+		virtual void Clear();
+
+		virtual void Refit(JobSystem* a_jobSystem, bool a_skipAsleep);
+		virtual void FindPairs(JobSystem* a_jobSystem, std::vector<CollisionPair>& a_pairs);
+
+		void Query(const glm::vec3& a_min, const glm::vec3& a_max, std::vector<Rigidbody*>& a_results) const;
+		virtual bool QueryPlane(const glm::vec3& a_normal, float a_dist, std::vector<Rigidbody*>& a_results) const;
+
+		virtual void Draw(DebugDraw* a_debugDraw, const glm::vec4& a_color) const;
+
+		virtual size_t	GetObjectCount() const		{ return m_entries.size(); }
+		int				GetHeight() const			{ return (m_root != -1) ? m_nodes[m_root].height : 0; }
+		unsigned int	GetReinsertCount() const	{ return m_reinsertCount; }		// How many objects escaped their fat bounds during the last refit
+	protected:
+		/**
+		*	@brief Node of the tree, leaves hold one object and internal nodes always have two children.
+		*/
+		struct Node {
+			glm::vec3	min;			// Fat bounds for leaves, bounds of both children for internal nodes
+			glm::vec3	max;
+			int			parent;			// Next free node while the node is unused
+			int			child1;
+			int			child2;
+			int			height;			// 0 for leaves, -1 while unused
+			int			entry;			// -1 for internal nodes
+
+			bool IsLeaf() const { return child1 == -1; }
+		};
+
+		/**
+		*	@brief Object held by the tree along with its leaf and its tight bounds as of the last refit.
+		*/
+		struct Entry {
+			Rigidbody*	obj;
+			int			leaf;
+			glm::vec3	min;
+			glm::vec3	max;
+		};
+
+		std::vector<Node>							m_nodes;
+		int											m_root = -1;
+		int											m_freeList = -1;
+
+		std::vector<Entry>							m_entries;
+		std::unordered_map<Rigidbody*, unsigned int> m_entryLookup;		// Object to entry index
+
+		float			m_margin;
+
+		unsigned int	m_reinsertCount = 0;
+
+		std::vector<unsigned int>					m_movedEntries;		// Entries that escaped their fat bounds during the last refit
+		std::vector<std::vector<unsigned int>>		m_threadMoved;		// Per-thread buffers for gathering moved entries (capacity is reused between steps)
+		std::vector<std::vector<CollisionPair>>		m_threadPairs;		// Per-thread pair buffers (capacity is reused between steps)
+	private:
+		int		AllocateNode();
+		void	FreeNode(int a_node);
+
+		void	InsertLeaf(int a_leaf);
+		void	RemoveLeaf(int a_leaf);
+		int		Balance(int a_node);
+		void	FixUpwards(int a_node);
+
+		void	QueryPairs(int a_node, unsigned int a_entry, std::vector<CollisionPair>& a_pairs) const;
+		void	QueryNode(int a_node, const glm::vec3& a_min, const glm::vec3& a_max, std::vector<Rigidbody*>& a_results) const;
+		void	QueryPlaneNode(int a_node, const glm::vec3& a_normal, float a_dist, std::vector<Rigidbody*>& a_results) const;
+	};
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+namespace Physebs {
+	/**
+	*	@brief Splits items that each write to up to two bodies (contacts, constraints) into batches where no body appears twice, so every item of a batch can be solved at once.
+	*	Items are colored greedily in the order they're added, each going in the first batch neither of its bodies is in yet. Batches keep the items in that order.
+	*	NOTE: Batches only depend on the items and the order they were added in, so solving batch by batch gives the same results however many threads solve each batch.
+	*/
+	class BatchColoring {
+	public:
+		static const unsigned int NO_BODY		= ~0u;		// Body the item doesn't write to (static or asleep), any number of items in a batch can share it
+		static const unsigned int MAX_BATCHES	= 64;		// Batches a body is tracked in, items that don't fit any of them go in one last batch that has to be solved serially
+
+		void			Begin(size_t a_bodyCount);										// Start over with bodies from 0 to count - 1 in no batches
+		void			Add(unsigned int a_first, unsigned int a_second);				// Color the next item, its index is how many items were added before it
+		void			End();															// Gather the items added into their batches
+
+		size_t				GetBatchCount() const					{ return m_batchStarts.empty() ? 0 : m_batchStarts.size() - 1; }
+		size_t				GetBatchSize(size_t a_batch) const		{ return m_batchStarts[a_batch + 1] - m_batchStarts[a_batch]; }
+		const unsigned int*	GetBatch(size_t a_batch) const			{ return m_batchItems.data() + m_batchStarts[a_batch]; }	// Indices of the batch's items
+		bool				GetIsBatchSerial(size_t a_batch) const	{ return a_batch == MAX_BATCHES; }							// Whether the batch's items can share bodies
+	protected:
+		std::vector<uint64_t>		m_bodyBatches;		// Bit per batch each body is in
+		std::vector<unsigned char>	m_itemBatches;		// Batch each item went in, in the order added
+		std::vector<unsigned int>	m_batchItems;		// Item indices grouped by batch
+		std::vector<size_t>			m_batchStarts;		// Where each batch starts in the grouped items, with the end of the last batch on the end
+	};
+}
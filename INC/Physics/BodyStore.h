@@ -0,0 +1,54 @@
+#pragma once
+
+#include <vector>
+#include <glm/vec3.hpp>
+
+namespace Physebs {
+	class Rigidbody;
+
+	/**
+	*	@brief Structure-of-arrays storage for the physics state of every Rigidbody owned by a scene.
+	*	Every array is indexed by the body's store index so per-body passes are linear sweeps over contiguous memory.
+	*	NOTE: Removing a body moves the last body into the freed slot, store indices are NOT stable across removals.
+	*/
+	struct BodyStore {
+		/**
+		*	@brief Wrapper so flags are stored as plain contiguous bools (std::vector<bool> is bit-packed and can't hand out bool pointers).
+		*/
+		struct Flag {
+			bool value;
+		};
+
+		static const unsigned int NO_ISLAND = ~0u;
+
+		unsigned int	Add(Rigidbody* a_obj);
+		void			Remove(Rigidbody* a_obj);		// Wakes the body's island first if it is asleep, whatever it was resting on may be gone
+		void			Clear();
+		void			Reserve(size_t a_count);
+
+		void			SleepIsland(const unsigned int* a_indices, size_t a_count);		// Put bodies to sleep as one island, sleeping islands they were part of are merged in
+		void			WakeIsland(unsigned int a_island);
+		void			WakeAll();
+
+		size_t			Size() const		{ return owners.size(); }
+
+		std::vector<glm::vec3>	pos;
+		std::vector<glm::vec3>	vel;
+		std::vector<glm::vec3>	accel;
+
+		std::vector<float>		mass;
+		std::vector<float>		invMass;		// Kept in step with mass so per-body passes multiply instead of divide
+		std::vector<float>		frict;
+		std::vector<float>		restitution;
+
+		std::vector<Flag>		dynamic;
+		std::vector<Flag>		asleep;			// Skipped by integration, broadphase updates and narrowphase until its island is woken
+		std::vector<float>		restTime;		// How long the body has been moving slower than SLEEP_VELOCITY
+		std::vector<unsigned int>	island;			// Sleeping island the body is part of, NO_ISLAND while awake
+
+		std::vector<Rigidbody*>	owners;			// Which Rigidbody is viewing each slot, used to patch store indices when slots move
+
+		std::vector<std::vector<Rigidbody*>>	islands;		// Bodies in each sleeping island (bodies rather than store indices as those move), unused islands are empty
+		std::vector<unsigned int>				freeIslands;	// Unused entries of the island list
+	};
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <vector>
+#include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
+#include "Physics/Collision.h"
+
+namespace Physebs {
+	class Rigidbody;
+	class DebugDraw;
+	class JobSystem;
+
+	/**
+	*	@brief Pure virtual class for structures that find which objects could be colliding without checking every pair's shapes.
+	*	The scene adds and removes objects along with its own, refits once per step after integration, then narrowphases the pairs found.
+	*	NOTE: Planes are infinite and are never inserted, the scene checks them separately (culled with QueryPlane where the structure supports it).
+	*/
+	class Broadphase {
+	public:
+		virtual ~Broadphase() {}
+
+		virtual void Insert(Rigidbody* a_obj) = 0;
+		virtual void Remove(Rigidbody* a_obj) = 0;
+		virtual void Clear() = 0;
+
+		virtual void Refit(JobSystem* a_jobSystem, bool a_skipAsleep) = 0;							// Catch up with how objects moved since the last refit, sleeping objects can be skipped if they were already asleep at the last refit
+		virtual void FindPairs(JobSystem* a_jobSystem, std::vector<CollisionPair>& a_pairs) = 0;	// Add every pair with overlapping bounds once, must follow a refit
+
+		virtual bool QueryPlane(const glm::vec3& /*a_normal*/, float /*a_dist*/, std::vector<Rigidbody*>& /*a_results*/) const { return false; }	// Add objects in branches touching the plane, false if the structure can't cull so every object needs checking
+		virtual void Draw(DebugDraw* /*a_debugDraw*/, const glm::vec4& /*a_color*/) const {}				// Optional debug geometry of the structure
+
+		virtual size_t GetObjectCount() const = 0;
+	};
+}
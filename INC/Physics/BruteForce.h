@@ -0,0 +1,40 @@
+#pragma once
+
+#include <vector>
+#include <unordered_map>
+#include <glm/vec3.hpp>
+#include "PhysebsUtility_Literals.h"
+#include "Physics/Broadphase.h"
+
+namespace Physebs {
+	/**
+	*	@brief O(n^2) broadphase, checks the bounds of every object against every other object.
+	*	Has no structure to keep up to date, so beats the others when there are only a handful of objects.
+	*	NOTE: Planes are infinite and are never inserted, check them against every object separately.
+	*/
+	class BruteForce : public Broadphase {
+	public:
+		virtual void Insert(Rigidbody* a_obj);
+		virtual void Remove(Rigidbody* a_obj);
+		virtual void Clear();
+
+		virtual void Refit(JobSystem* a_jobSystem, bool a_skipAsleep);
+		virtual void FindPairs(JobSystem* a_jobSystem, std::vector<CollisionPair>& a_pairs);
+
+		virtual size_t	GetObjectCount() const		{ return m_entries.size(); }
+	protected:
+		/**
+		*	@brief Object held by the broadphase along with its bounds as of the last refit.
+		*/
+		struct Entry {
+			Rigidbody*	obj;
+			glm::vec3	min;
+			glm::vec3	max;
+		};
+
+		std::vector<Entry>							m_entries;
+		std::unordered_map<Rigidbody*, unsigned int> m_entryLookup;		// Object to entry index
+
+		std::vector<std::vector<CollisionPair>>		m_threadPairs;		// Per-thread pair buffers (capacity is reused between steps)
+	};
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <glm/vec3.hpp>
+
+namespace Physebs {
+	class Rigidbody;
+
+	/**
+	*	@brief Structure for holding collision data.
+	*/
+	struct Collision {
+		Collision(Rigidbody* a_actor, Rigidbody* a_other, const glm::vec3& a_collisionNormal = glm::vec3(), float a_overlap = 0.f) 
+			: actor(a_actor), other(a_other), collisionNormal(a_collisionNormal), overlap(a_overlap) {}
+
+	public:
+		Rigidbody* actor;
+		Rigidbody* other;
+
+		float overlap;				// The overlap between the colliding object's shapes
+
+		glm::vec3 collisionNormal;	// The direction to base collision knockback on
+
+		/**
+		*	@brief Swap actor with other to use the main is colliding function in order to avoid duplicate code.
+		*	@return void.
+		*/
+		void SwapObjects() {
+			Rigidbody * tmp = actor;
+
+			actor = other;
+			other = tmp;
+		}
+	};
+
+	/**
+	*	@brief Two objects whose bounds overlap, found by a broadphase and handed to the narrowphase to check properly.
+	*/
+	struct CollisionPair {
+		Rigidbody* actor;
+		Rigidbody* other;
+	};
+
+	/**
+	*	@brief Broadphase pair sorted into a narrowphase bucket, in the order the bucket's colliding check expects, along with where it was in the broadphase's list.
+	*/
+	struct BucketPair {
+		Rigidbody*		actor;
+		Rigidbody*		other;
+		unsigned int	pairIndex;
+	};
+}
@@ -0,0 +1,140 @@
+#pragma once
+
+#include <utility>
+#include "Physics/Rigidbody.h"
+#include "Physics/Collision.h"
+#include "Physics/Scene.h"
+
+namespace Physebs {
+	/**
+	*	@brief Colliding check for a pair of shapes, the actor having the first shape.
+	*	Shapes that can collide specialise this with b_defined = true and a static bool IsColliding(Collision&), only one order of each pair is needed.
+	*	A specialisation can also give a batch kernel as a static int BatchMask(const BucketPair*, size_t) (see Scene::SphereSphereBatchMask).
+	*	NOTE: Adding a shape only needs its eShape value and these specialisations, the dispatch table and narrowphase buckets are generated from them.
+	*/
+	template <eShape Actor, eShape Other>
+	struct ShapePairTest {
+		static const bool b_defined = false;
+	};
+
+	template <>
+	struct ShapePairTest<SPHERE, SPHERE> {
+		static const bool b_defined = true;
+
+		static bool IsColliding(Collision& a_collision)						{ return Scene::IsColliding_Sphere_Sphere(a_collision); }
+		static int	BatchMask(const BucketPair* a_pairs, size_t a_count)	{ return Scene::SphereSphereBatchMask(a_pairs, a_count); }
+	};
+
+	template <>
+	struct ShapePairTest<AA_BOX, SPHERE> {
+		static const bool b_defined = true;
+
+		static bool IsColliding(Collision& a_collision)						{ return Scene::IsColliding_AABB_Sphere(a_collision); }
+	};
+
+	template <>
+	struct ShapePairTest<AA_BOX, AA_BOX> {
+		static const bool b_defined = true;
+
+		static bool IsColliding(Collision& a_collision)						{ return Scene::IsColliding_AABB_AABB(a_collision); }
+		static int	BatchMask(const BucketPair* a_pairs, size_t a_count)	{ return Scene::BoxBoxBatchMask(a_pairs, a_count); }
+	};
+
+	template <>
+	struct ShapePairTest<PLANE, SPHERE> {
+		static const bool b_defined = true;
+
+		static bool IsColliding(Collision& a_collision)						{ return Scene::IsColliding_Plane_Sphere(a_collision); }
+	};
+
+	template <>
+	struct ShapePairTest<PLANE, AA_BOX> {
+		static const bool b_defined = true;
+
+		static bool IsColliding(Collision& a_collision)						{ return Scene::IsColliding_Plane_AABB(a_collision); }
+	};
+
+	/**
+	*	@brief Resolves which colliding check a pair of shapes uses at compile time, swapping the collision's objects when only the other order has a check.
+	*	NOTE: Check has no branches on shape, so it can be called directly (and inlined) by loops over pairs of known shapes.
+	*/
+	template <eShape Actor, eShape Other>
+	struct ShapePairDispatch {
+		static const bool	b_swap		= !ShapePairTest<Actor, Other>::b_defined && ShapePairTest<Other, Actor>::b_defined;
+		static const bool	b_colliding = ShapePairTest<Actor, Other>::b_defined || b_swap;			// Whether the shapes can collide at all
+		static const int	BUCKET		= !b_colliding ? -1 : (b_swap ? Other * SHAPE_COUNT + Actor : Actor * SHAPE_COUNT + Other);
+
+		static bool Check(Collision& a_collision) {
+			return CheckPair(a_collision, std::integral_constant<int, !b_colliding ? 0 : (b_swap ? 2 : 1)>());
+		}
+
+		// Batch kernel of the pair's check, passes every pair on if it doesn't have one
+		static int BatchMask(const BucketPair* a_pairs, size_t a_count) {
+			return SelectBatchMask(a_pairs, a_count, 0);
+		}
+	private:
+		static bool CheckPair(Collision&, std::integral_constant<int, 0>) {
+			return false;
+		}
+
+		static bool CheckPair(Collision& a_collision, std::integral_constant<int, 1>) {
+			return ShapePairTest<Actor, Other>::IsColliding(a_collision);
+		}
+
+		static bool CheckPair(Collision& a_collision, std::integral_constant<int, 2>) {
+			a_collision.SwapObjects();
+
+			return ShapePairTest<Other, Actor>::IsColliding(a_collision);
+		}
+
+		template <class Test = ShapePairTest<Actor, Other>>
+		static auto SelectBatchMask(const BucketPair* a_pairs, size_t a_count, int) -> decltype(Test::BatchMask(a_pairs, a_count)) {
+			return Test::BatchMask(a_pairs, a_count);
+		}
+
+		static int SelectBatchMask(const BucketPair*, size_t a_count, long) {
+			return (1 << a_count) - 1;
+		}
+	};
+
+	template <size_t Index>
+	using ShapePairDispatchAt = ShapePairDispatch<(eShape)(Index / SHAPE_COUNT), (eShape)(Index % SHAPE_COUNT)>;
+
+	typedef bool(*CollidingCheck)(Collision& a_collision);
+
+	/**
+	*	@brief How a combination of shapes is checked, for when the shapes are only known at runtime.
+	*/
+	struct ShapePairRoute {
+		CollidingCheck	check;		// Checks the pair in the order given, swapping the objects if needed
+		int				bucket;		// Narrowphase bucket the pair goes in, -1 if the shapes can't collide
+		bool			b_swap;		// Whether the pair has to be swapped to go in the bucket
+	};
+
+	/**
+	*	@brief Table of routes for every combination of shapes, generated from ShapePairDispatch.
+	*/
+	template <class Indices>
+	struct ShapePairRoutes;
+
+	template <size_t... Indices>
+	struct ShapePairRoutes<std::index_sequence<Indices...>> {
+		static const ShapePairRoute routes[sizeof...(Indices)];
+	};
+
+	template <size_t... Indices>
+	const ShapePairRoute ShapePairRoutes<std::index_sequence<Indices...>>::routes[sizeof...(Indices)] = {
+		{ &ShapePairDispatchAt<Indices>::Check, ShapePairDispatchAt<Indices>::BUCKET, ShapePairDispatchAt<Indices>::b_swap }...
+	};
+
+	/**
+	*	@brief Look up how a pair of shapes is checked.
+	*	@param a_actor is the shape of the collision's actor.
+	*	@param a_other is the shape of the collision's other.
+	*	@return Route for the pair of shapes.
+	*/
+	inline const ShapePairRoute& GetShapePairRoute(eShape a_actor, eShape a_other)
+	{
+		return ShapePairRoutes<std::make_index_sequence<SHAPE_COUNT * SHAPE_COUNT>>::routes[a_actor * SHAPE_COUNT + a_other];
+	}
+}
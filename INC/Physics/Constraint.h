@@ -7,9 +7,11 @@ namespace Physebs {
 	enum eConstraint { SPRING, JOINT };
 
 	class Rigidbody;
+	class DebugDraw;
 
 	/**
 	*	@brief Pure abstract class representing a relationship between two objects that affects how they exist in relation to other in the simulation.
+	*	NOTE: The scene runs constraints that don't share objects at the same time on different threads, so Update must only write to its own attached objects.
 	*/
 	class Constraint {
 	public:
@@ -19,7 +21,7 @@ namespace Physebs {
 		virtual void Update();
 		virtual void Constrain() = 0;
 
-		virtual void Draw() = 0;
+		virtual void Draw(DebugDraw* a_debugDraw) = 0;
 
 		bool ContainsObj(Rigidbody* a_obj);
 
@@ -34,9 +36,14 @@ namespace Physebs {
 		Rigidbody* m_attachedActor;
 		Rigidbody* m_attachedOther;
 
+		friend class Scene;				// Scene tracks where the constraint is in its list to remove it without searching
+
 		eConstraint m_type;
 
 		glm::vec4	m_color;
+
+		unsigned int m_sceneIndex = 0;		// Index in the owning scene's constraint list
+		bool		 b_destroyQueued = false;	// Whether the scene has queued destroying it at the end of the step
 	private:
 	};
 }
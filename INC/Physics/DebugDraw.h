@@ -0,0 +1,22 @@
+#pragma once
+
+#include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
+
+namespace Physebs {
+	/**
+	*	@brief Pure abstract sink that the scene sends debug geometry to, so the engine never depends on a renderer directly.
+	*	Applications implement this with whatever renderer they have (e.g. aie::Gizmos) and hand it to the scene with SetDebugDraw.
+	*	NOTE: AABB functions take HALF extents to match bootstrap Gizmos.
+	*/
+	class DebugDraw {
+	public:
+		virtual ~DebugDraw() {}
+
+		virtual void AddAABB(const glm::vec3& a_center, const glm::vec3& a_halfExtents, const glm::vec4& a_color) = 0;
+		virtual void AddAABBFilled(const glm::vec3& a_center, const glm::vec3& a_halfExtents, const glm::vec4& a_color) = 0;
+		virtual void AddSphere(const glm::vec3& a_center, float a_radius, int a_rows, int a_columns, const glm::vec4& a_color) = 0;
+		virtual void AddLine(const glm::vec3& a_start, const glm::vec3& a_end, const glm::vec4& a_color) = 0;
+		virtual void AddTri(const glm::vec3& a_v0, const glm::vec3& a_v1, const glm::vec3& a_v2, const glm::vec4& a_color) = 0;
+	};
+}
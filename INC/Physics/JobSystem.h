@@ -0,0 +1,130 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Physebs {
+	/**
+	*	@brief Pool of worker threads that split parallel-for ranges into chunks and balance them with work stealing.
+	*	Every thread owns a queue, pops its own chunks from the back and steals from the front of other queues when it runs dry.
+	*	NOTE: The thread calling ParallelFor works on chunks too (thread index 0), so a thread count of 1 runs everything serially on the caller.
+	*/
+	class JobSystem {
+	public:
+		// Job run over [a_begin, a_end) of a parallel-for range. a_threadIndex is in [0, GetThreadCount()) and is unique among concurrently running chunks.
+		typedef std::function<void(size_t a_begin, size_t a_end, unsigned int a_threadIndex)> Job;
+
+		JobSystem(unsigned int a_threadCount = 1);		// 0 = one thread per hardware core
+		~JobSystem();
+
+		void ParallelFor(size_t a_count, size_t a_grainSize, const Job& a_job);
+
+		template<class T, class Fn>
+		void ParallelForCollect(size_t a_count, size_t a_grainSize, std::vector<std::vector<T>>& a_threadBuffers, std::vector<T>& a_out, const Fn& a_fn);
+
+		unsigned int GetThreadCount() const { return m_threadCount; }
+	protected:
+		/**
+		*	@brief Chunk of a parallel-for range waiting to be run.
+		*/
+		struct Task {
+			const Job*			job;
+			size_t				begin;
+			size_t				end;
+			std::atomic<size_t>* remaining;		// Chunks of the owning parallel-for that are still unfinished
+		};
+
+		/**
+		*	@brief Per-thread task queue, owner pops from the back and thieves steal from the front.
+		*/
+		struct WorkQueue {
+			std::mutex			mutex;
+			std::deque<Task>	tasks;
+		};
+
+		unsigned int					m_threadCount;
+		std::unique_ptr<WorkQueue[]>	m_queues;		// One queue per thread, index 0 belongs to the calling thread
+		std::vector<std::thread>		m_workers;
+
+		std::mutex						m_wakeMutex;
+		std::condition_variable			m_wakeCondition;
+		std::atomic<size_t>				m_pendingTasks;	// Tasks queued but not yet taken, workers sleep while this is 0
+		bool							b_quit = false;
+	private:
+		void WorkerLoop(unsigned int a_threadIndex);
+		bool TryGetTask(unsigned int a_threadIndex, Task& a_task);
+		void RunTask(const Task& a_task, unsigned int a_threadIndex);
+	};
+
+	/**
+	*	@brief Parallel-for where every item can output any number of results, gathered into one list in item order.
+	*	Each thread appends to its own buffer and records which part of it each chunk wrote, chunks are then merged in order
+	*	so the output is the same no matter how many threads ran or who stole what.
+	*	@param a_count is the number of items in the range.
+	*	@param a_grainSize is the number of items per chunk.
+	*	@param a_threadBuffers is scratch space for the per-thread buffers, keep it between calls to reuse its capacity.
+	*	@param a_out is the list to append results to.
+	*	@param a_fn is called as a_fn(size_t a_index, std::vector<T>& a_results) for every item.
+	*	@return void.
+	*/
+	template<class T, class Fn>
+	void JobSystem::ParallelForCollect(size_t a_count, size_t a_grainSize, std::vector<std::vector<T>>& a_threadBuffers, std::vector<T>& a_out, const Fn& a_fn)
+	{
+		/**
+		*	@brief Range of a thread's buffer written by one chunk.
+		*/
+		struct ChunkRange {
+			unsigned int	threadIndex;
+			size_t			begin;
+			size_t			end;
+		};
+
+		if (a_count == 0) {
+			return;
+		}
+
+		if (a_grainSize == 0) {
+			a_grainSize = 1;
+		}
+
+		a_threadBuffers.resize(m_threadCount);
+
+		std::vector<ChunkRange> chunkRanges((a_count + a_grainSize - 1) / a_grainSize);
+
+		ParallelFor(a_count, a_grainSize, [&](size_t a_begin, size_t a_end, unsigned int a_threadIndex) {
+			std::vector<T>& threadBuffer = a_threadBuffers[a_threadIndex];
+
+			// Serial fallback hands over the whole range at once, so walk it a chunk at a time
+			for (size_t chunkBegin = a_begin; chunkBegin < a_end; chunkBegin += a_grainSize) {
+				size_t		chunkEnd	= (chunkBegin + a_grainSize < a_end) ? chunkBegin + a_grainSize : a_end;
+				ChunkRange& range		= chunkRanges[chunkBegin / a_grainSize];
+
+				range.threadIndex	= a_threadIndex;
+				range.begin			= threadBuffer.size();
+
+				for (size_t i = chunkBegin; i < chunkEnd; ++i) {
+					a_fn(i, threadBuffer);
+				}
+
+				range.end			= threadBuffer.size();
+			}
+		});
+
+		// Merge in chunk order
+		for (auto& range : chunkRanges) {
+			std::vector<T>& threadBuffer = a_threadBuffers[range.threadIndex];
+
+			a_out.insert(a_out.end(), threadBuffer.begin() + range.begin, threadBuffer.begin() + range.end);
+		}
+
+		for (auto& threadBuffer : a_threadBuffers) {
+			threadBuffer.clear();
+		}
+	}
+}
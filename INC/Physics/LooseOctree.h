@@ -0,0 +1,91 @@
+#pragma once
+
+#include <vector>
+#include <unordered_map>
+#include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
+#include "PhysebsUtility_Literals.h"
+#include "Physics/Broadphase.h"
+
+namespace Physebs {
+	class Rigidbody;
+	class DebugDraw;
+	class JobSystem;
+
+	/**
+	*	@brief Persistent loose octree broadphase, objects stay in their cell between steps and only move when they leave its loosened bounds.
+	*	Every cell's loose bounds are its bounds scaled up by the looseness, an object lives in the deepest cell whose loose bounds fully contain it.
+	*	Cells are only subdivided once they hold more objects than the split threshold, and never get freed (they are reused as objects come back).
+	*	NOTE: Planes are infinite and are never inserted, use QueryPlane to find the objects that could be touching one.
+	*	NOTE: Objects outside of the root's loose bounds are kept in the root cell, nothing is culled.
+	*/
+	class LooseOctree : public Broadphase {
+	public:
+		LooseOctree(const glm::vec3& a_origin, const glm::vec3& a_halfExtents, float a_looseness = LOOSE_OCTREE_LOOSENESS,
+			unsigned int a_splitThreshold = LOOSE_OCTREE_SPLIT_THRESHOLD, unsigned int a_maxDepth = LOOSE_OCTREE_MAX_DEPTH);
+
+		virtual void Insert(Rigidbody* a_obj);
+		virtual void Remove(Rigidbody* a_obj);
+		virtual void Clear();
+
+		virtual void Refit(JobSystem* a_jobSystem, bool a_skipAsleep);
+		virtual void FindPairs(JobSystem* a_jobSystem, std::vector<CollisionPair>& a_pairs);
+
+		virtual bool QueryPlane(const glm::vec3& a_normal, float a_dist, std::vector<Rigidbody*>& a_results) const;
+
+		virtual void Draw(DebugDraw* a_debugDraw, const glm::vec4& a_color) const;
+
+		virtual size_t	GetObjectCount() const		{ return m_entries.size(); }
+		size_t			GetCellCount() const		{ return m_cells.size(); }
+		unsigned int	GetReinsertCount() const	{ return m_reinsertCount; }		// How many objects changed cell during the last refit
+	protected:
+		/**
+		*	@brief Cubic volume of the tree, children are stored as 8 consecutive cells.
+		*/
+		struct Cell {
+			glm::vec3					center;
+			float						halfSize;
+			int							parent;
+			int							firstChild;		// -1 if the cell has not been subdivided
+			unsigned int				depth;
+			unsigned int				subtreeCount;	// Entries in this cell and all of its descendants, empty subtrees are skipped by queries
+			std::vector<unsigned int>	entries;		// Indices of the entries living in this cell
+		};
+
+		/**
+		*	@brief Object held by the tree along with where it lives and its bounds as of the last refit.
+		*/
+		struct Entry {
+			Rigidbody*		obj;
+			int				cell;
+			unsigned int	slot;						// Index in the cell's entry list
+			glm::vec3		min;
+			glm::vec3		max;
+		};
+
+		std::vector<Cell>							m_cells;			// Index 0 is the root
+		std::vector<Entry>							m_entries;
+		std::unordered_map<Rigidbody*, unsigned int> m_entryLookup;		// Object to entry index
+
+		float			m_looseness;
+		unsigned int	m_splitThreshold;
+		unsigned int	m_maxDepth;
+
+		unsigned int	m_reinsertCount = 0;
+
+		std::vector<unsigned int>					m_movedEntries;		// Entries that left their cell during the last refit
+		std::vector<std::vector<unsigned int>>		m_threadMoved;		// Per-thread buffers for gathering moved entries (capacity is reused between steps)
+		std::vector<std::vector<CollisionPair>>		m_threadPairs;		// Per-thread pair buffers (capacity is reused between steps)
+	private:
+		void	InsertEntry(unsigned int a_entry, int a_startCell);
+		void	DetachEntry(unsigned int a_entry);
+		void	Subdivide(int a_cell);
+		void	AdjustSubtreeCount(int a_cell, int a_delta);
+		void	QueryCell(int a_cell, unsigned int a_entry, std::vector<CollisionPair>& a_pairs) const;
+		void	QueryPlaneCell(int a_cell, const glm::vec3& a_normal, float a_dist, std::vector<Rigidbody*>& a_results) const;
+
+		int		ChildContaining(int a_cell, const glm::vec3& a_point) const;
+		bool	LooseContains(int a_cell, const glm::vec3& a_min, const glm::vec3& a_max) const;
+		bool	LooseOverlaps(int a_cell, const glm::vec3& a_min, const glm::vec3& a_max) const;
+	};
+}
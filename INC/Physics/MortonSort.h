@@ -0,0 +1,31 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include "PhysebsUtility_Literals.h"
+
+namespace Physebs {
+	class JobSystem;
+
+	uint64_t MortonEncode(uint32_t a_x, uint32_t a_y, uint32_t a_z);		// Interleave the lower 21 bits of each coordinate, x in the lowest bit
+
+	/**
+	*	@brief Something to be sorted by its Morton key, e.g. an object index and a cell it touches.
+	*/
+	struct MortonEntry {
+		uint64_t		key;
+		unsigned int	index;
+	};
+
+	/**
+	*	@brief Parallel least significant digit radix sort for Morton keyed entries, keeps its scratch memory between sorts.
+	*	The list is split into fixed chunks that are counted and scattered concurrently, so the result is stable and doesn't depend on the thread count.
+	*/
+	class MortonSorter {
+	public:
+		void Sort(JobSystem* a_jobSystem, std::vector<MortonEntry>& a_entries, unsigned int a_keyBits);
+	protected:
+		std::vector<MortonEntry>	m_scratch;
+		std::vector<unsigned int>	m_histograms;		// One set of bucket counts per chunk, turned into where each chunk writes each bucket
+	};
+}
@@ -0,0 +1,114 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <utility>
+#include <type_traits>
+#include <assert.h>
+#include "PhysebsUtility_Literals.h"
+
+namespace Physebs {
+	/**
+	*	@brief Slab allocator for one type of object, objects are constructed in fixed size slabs so they sit next to each other in memory.
+	*	Destroyed objects' slots go on a free list and are handed out again first. Slabs are kept until the pool is destroyed, so refilling a reset pool doesn't allocate.
+	*	NOTE: Reset forgets every object without running destructors, only pool types whose destructors do nothing (e.g. Rigidbody and Constraint types).
+	*/
+	template <class T>
+	class ObjectPool {
+	public:
+		ObjectPool() = default;
+		ObjectPool(const ObjectPool&) = delete;
+		ObjectPool& operator=(const ObjectPool&) = delete;
+
+		/**
+		*	@brief Construct an object in a free slot, starting a new slab if every slot is in use.
+		*	@param a_args are passed on to the object's constructor.
+		*	@return Pointer to the new object, stays valid until it is destroyed or the pool is reset.
+		*/
+		template <class... Args>
+		T* Create(Args&&... a_args)
+		{
+			Slot* slot = m_freeList;
+
+			if (slot != nullptr) {
+				m_freeList = slot->next;
+			}
+			else {
+				// Current slab is full, move onto the next one (kept from before a reset or newly allocated)
+				if (m_slabs.empty() || m_slabUsed == POOL_SLAB_SIZE) {
+					if (!m_slabs.empty()) {
+						m_slabIndex++;
+					}
+
+					if (m_slabIndex == m_slabs.size()) {
+						m_slabs.emplace_back(new Slot[POOL_SLAB_SIZE]);
+					}
+
+					m_slabUsed = 0;
+				}
+
+				slot = &m_slabs[m_slabIndex][m_slabUsed++];
+			}
+
+			return new (&slot->storage) T(std::forward<Args>(a_args)...);
+		}
+
+		/**
+		*	@brief Make sure there are slabs for creating a number of objects without allocating part way through (e.g. before mass spawning).
+		*	NOTE: Free slots of destroyed objects aren't counted, so this may keep a slab more than is needed.
+		*	@param a_count is how many more objects to make room for.
+		*	@return void.
+		*/
+		void Reserve(size_t a_count)
+		{
+			// Slots left in the current slab and in slabs kept from before a reset
+			size_t available = m_slabs.empty() ? 0 : (m_slabs.size() - m_slabIndex) * POOL_SLAB_SIZE - m_slabUsed;
+
+			while (available < a_count) {
+				m_slabs.emplace_back(new Slot[POOL_SLAB_SIZE]);
+				available += POOL_SLAB_SIZE;
+			}
+		}
+
+		/**
+		*	@brief Destroy an object created by this pool and free its slot for reuse.
+		*	@param a_obj is the object to destroy.
+		*	@return void.
+		*/
+		void Destroy(T* a_obj)
+		{
+			assert(a_obj != nullptr && "Attempted to destroy a null object.");
+
+			a_obj->~T();
+
+			Slot* slot = reinterpret_cast<Slot*>(a_obj);
+			slot->next = m_freeList;
+			m_freeList = slot;
+		}
+
+		/**
+		*	@brief Forget every object at once, keeping the slabs to be filled again.
+		*	NOTE: O(1), destructors aren't run and pointers to the pool's objects are left dangling.
+		*	@return void.
+		*/
+		void Reset()
+		{
+			m_freeList	= nullptr;
+			m_slabIndex = 0;
+			m_slabUsed	= 0;
+		}
+	protected:
+		/**
+		*	@brief Storage for one object, or a link to the next free slot while it is unused.
+		*/
+		union Slot {
+			Slot*													next;
+			typename std::aligned_storage<sizeof(T), alignof(T)>::type	storage;
+		};
+
+		std::vector<std::unique_ptr<Slot[]>>	m_slabs;
+		size_t									m_slabIndex = 0;		// Slab slots are currently being handed out from
+		size_t									m_slabUsed	= 0;		// Slots of the current slab handed out since it was started
+		Slot*									m_freeList	= nullptr;	// Slots of destroyed objects, handed out before any new ones
+	};
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+namespace Physebs {
+	/**
+	*	@brief Set of unordered pairs of ids, used to drop pairs a broadphase found more than once.
+	*	Each pair is packed into a single 64 bit key in a flat open-addressing table, clearing keeps the table's memory.
+	*	NOTE: Ids must be unique per object (e.g. an index into this step's object list), (a, b) and (b, a) are the same pair.
+	*/
+	class PairSet {
+	public:
+		void	Reset(size_t a_maxPairs);								// Empty the set, sizing it to hold up to the given number of pairs
+		bool	Insert(unsigned int a_first, unsigned int a_second);	// Add a pair, returns false if it was already in the set
+
+		size_t	GetCount() const		{ return m_count; }
+	protected:
+		std::vector<uint64_t>	m_keys;				// Power of two sized, linear probing
+		unsigned int			m_shift = 64;		// 64 - log2(table size), for turning a hash into a slot index
+		size_t					m_count = 0;
+		size_t					m_maxPairs = 0;
+	};
+}
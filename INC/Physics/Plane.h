@@ -1,6 +1,6 @@
 #pragma once
 
-#include "Physics\Rigidbody.h"
+#include "Physics/Rigidbody.h"
 #include <glm/vec2.hpp>
 
 namespace Physebs {
@@ -13,10 +13,11 @@ namespace Physebs {
 
 		virtual ~Plane();
 
-		virtual void Draw();
+		virtual void Draw(DebugDraw* a_debugDraw);
 
-		// Override update to ensure acceleration is applied to distance from origin instead of position
-		virtual void Update(float a_dt);
+		virtual void CalculateBounds(glm::vec3& a_min, glm::vec3& a_max) const;
+
+		void UpdateOriginDist(float a_dt);
 
 		float*				GetDistRef()							{ return &m_originDist; }
 		float				GetDist() const							{ return m_originDist; }
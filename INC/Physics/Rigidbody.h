@@ -3,13 +3,27 @@
 #include <glm/vec3.hpp>
 #include <glm/vec4.hpp>
 #include "PhysebsUtility_Literals.h"
+#include "Physics/BodyStore.h"
 
 /**
 *	@brief Pure virtual class for objects affected by physics.
+*	NOTE: Once added to a scene the physics state (position, velocity, acceleration, mass, friction, restitution and dynamic flag)
+*	lives in the scene's BodyStore and the Rigidbody becomes a view over its slot. Until then the state is held locally.
 */
 namespace Physebs {
 	
-	enum eShape {SPHERE, PLANE, AA_BOX};			// enums can't have name of an existing data-type or compiler will get confused (e.g. AABB)
+	class DebugDraw;
+
+	enum eShape {SPHERE, PLANE, AA_BOX, SHAPE_COUNT};			// enums can't have name of an existing data-type or compiler will get confused (e.g. AABB)
+
+	/**
+	*	@brief Generational reference to an object in a scene, unlike a pointer it goes stale (rather than pointing at whatever reused the memory) once the object is destroyed.
+	*	NOTE: Look up with Scene::GetObjectByHandle, which returns null for stale handles.
+	*/
+	struct BodyHandle {
+		unsigned int index		= ~0u;		// Slot in the scene's handle map
+		unsigned int generation = 0;		// Bumped every time the slot is freed
+	};
 
 	class Rigidbody {
 	public:
@@ -24,45 +38,60 @@ namespace Physebs {
 		virtual void ApplyForce(const glm::vec3& a_force);
 		virtual void ApplyImpulseForce(const glm::vec3& a_force);
 
-		virtual void Update(float a_dt);
-		virtual void Draw() = 0;
+		virtual void Draw(DebugDraw* a_debugDraw) = 0;
+
+		virtual void CalculateBounds(glm::vec3& a_min, glm::vec3& a_max) const = 0;		// World space box enclosing the whole shape, used by the broadphase
 
 		unsigned int		GetID() const						{ return m_id; }
-		void				SetID(unsigned int a_id)			{ m_id = a_id; }
+		BodyHandle			GetHandle() const					{ return m_handle; }		// NOTE: Only valid while owned by a scene
 
-		float*				GetPosRef()							{ return &m_pos.x; }
-		const glm::vec3&	GetPos() const						{ return m_pos; }
-		void				SetPos(const glm::vec3& a_pos)		{ m_pos = a_pos; }
+		float*				GetPosRef()							{ Wake(); return &PosData().x; }		// Wakes the body, it may be moved through the pointer
+		const glm::vec3&	GetPos() const						{ return m_store ? m_store->pos[m_storeIndex] : m_pos; }
+		void				SetPos(const glm::vec3& a_pos)		{ Wake(); PosData() = a_pos; }
 
-		const glm::vec3&	GetVel() const						{ return m_vel; }
-		void				SetVel(const glm::vec3& a_vel)		{ m_vel = a_vel; }
+		const glm::vec3&	GetVel() const						{ return m_store ? m_store->vel[m_storeIndex] : m_vel; }
+		void				SetVel(const glm::vec3& a_vel)		{ Wake(); VelData() = a_vel; }
 		
-		const glm::vec3&	GetAccel() const					{ return m_accel; }
-		void				SetAccel(const glm::vec3& a_accel)	{ m_accel = a_accel; }
+		const glm::vec3&	GetAccel() const					{ return m_store ? m_store->accel[m_storeIndex] : m_accel; }
+		void				SetAccel(const glm::vec3& a_accel)	{ AccelData() = a_accel; }
 
 		float*				GetColorRef()						{ return &m_color.r; }
 		const glm::vec4&	GetColor() const					{ return m_color; }
 		void				SetColor(const glm::vec4& a_color)	{ m_color = a_color; }
 
-		float*				GetMassRef()						{ return &m_mass; }
-		float				GetMass() const						{ return m_mass; }
-		void				SetMass(float a_mass)				{ m_mass = a_mass; }
+		float				GetMass() const						{ return m_store ? m_store->mass[m_storeIndex] : m_mass; }
+		float				GetInvMass() const					{ return m_store ? m_store->invMass[m_storeIndex] : 1.f / m_mass; }
+		void				SetMass(float a_mass);				// NOTE: No reference getter, the store's inverse mass has to be updated with it
 
-		float*				GetFrictRef()						{ return &m_frict; }
-		float				GetFrict() const					{ return m_frict; }
-		void				SetFrict(float a_frict)				{ m_frict = a_frict; }
+		float*				GetFrictRef()						{ return &FrictData(); }
+		float				GetFrict() const					{ return m_store ? m_store->frict[m_storeIndex] : m_frict; }
+		void				SetFrict(float a_frict)				{ FrictData() = a_frict; }
 
 		eShape				GetShape() const					{ return m_shape; }
 
-		bool*				GetIsDynamicRef()					{ return &b_dynamic; }
-		bool				GetIsDynamic() const				{ return b_dynamic; }
-		void				SetIsDynamic(bool a_isDynamic)		{ b_dynamic = a_isDynamic; }
+		bool*				GetIsDynamicRef()					{ return &DynamicData(); }
+		bool				GetIsDynamic() const				{ return m_store ? m_store->dynamic[m_storeIndex].value : b_dynamic; }
+		void				SetIsDynamic(bool a_isDynamic)		{ DynamicData() = a_isDynamic; }
+
+		bool				GetIsAsleep() const					{ return m_store && m_store->asleep[m_storeIndex].value; }		// NOTE: Bodies are only put to sleep by a scene
+		bool				GetIsActive() const					{ return GetIsDynamic() && !GetIsAsleep(); }					// Whether the body is being moved by the simulation
+		void				Wake();								// Wake the sleeping island the body is part of, does nothing if it is awake
 
-		float				GetRestitution() const				{ return m_restitution; }
-		float*				GetRestitutionRef()					{ return &m_restitution; }
+		float				GetRestitution() const				{ return m_store ? m_store->restitution[m_storeIndex] : m_restitution; }
+		float*				GetRestitutionRef()					{ return &RestitutionData(); }
+
+		unsigned int		GetStoreIndex() const				{ return m_storeIndex; }		// NOTE: Only meaningful while owned by a scene, changes when other bodies are removed
 	protected:
+		friend struct BodyStore;	// Store moves physics state in and out of the body when it is added or removed from a scene
+		friend class Scene;			// Scene keeps its ID lookup in step when changing IDs, and hands out handles
+
+		void SetID(unsigned int a_id)	{ m_id = a_id; }
+
 		unsigned int m_id;
+		BodyHandle	 m_handle;
+		bool		 b_destroyQueued = false;	// Whether the scene has queued destroying it at the end of the step
 
+		// Physics state used while the body is not owned by a scene (see BodyStore)
 		glm::vec3 m_pos;
 		glm::vec3 m_vel;
 		glm::vec3 m_accel;	
@@ -76,6 +105,17 @@ namespace Physebs {
 		bool b_dynamic;			// Whether rigidbody is affected by physics or not
 
 		eShape m_shape;			// Be able to quickly determine what shape we're dealing with. DO NOT ALLOW TO BE MODIFIED.
+
+		BodyStore*		m_store			= nullptr;		// Scene store holding the physics state, null if not owned by a scene
+		unsigned int	m_storeIndex	= 0;
 	private:
+		// Resolve where physics state currently lives (scene store slot or local fallback)
+		glm::vec3&	PosData()			{ return m_store ? m_store->pos[m_storeIndex] : m_pos; }
+		glm::vec3&	VelData()			{ return m_store ? m_store->vel[m_storeIndex] : m_vel; }
+		glm::vec3&	AccelData()			{ return m_store ? m_store->accel[m_storeIndex] : m_accel; }
+		float&		MassData()			{ return m_store ? m_store->mass[m_storeIndex] : m_mass; }
+		float&		FrictData()			{ return m_store ? m_store->frict[m_storeIndex] : m_frict; }
+		float&		RestitutionData()	{ return m_store ? m_store->restitution[m_storeIndex] : m_restitution; }
+		bool&		DynamicData()		{ return m_store ? m_store->dynamic[m_storeIndex].value : b_dynamic; }
 	};
 }
@@ -1,13 +1,38 @@
 #pragma once
 
 #include <vector>
+#include <utility>
+#include <tuple>
+#include <unordered_map>
+#include <functional>
+#include <cstdint>
 #include <glm/vec3.hpp>
 #include <glm/vec4.hpp>
 #include "PhysebsUtility_Literals.h"
-#include "Octree\Octree.h"
-#include <Gizmos.h>
+#include "Octree/Octree.h"
+#include "Physics/Collision.h"
+#include "Physics/Rigidbody.h"
+#include "Physics/Sphere.h"
+#include "Physics/Plane.h"
+#include "Physics/AABB.h"
+#include "Physics/Spring.h"
+#include "Physics/ObjectPool.h"
+#include "Physics/DebugDraw.h"
+#include "Physics/BodyStore.h"
+#include "Physics/SpringStore.h"
+#include "Physics/JobSystem.h"
+#include "Physics/Broadphase.h"
+#include "Physics/BruteForce.h"
+#include "Physics/LooseOctree.h"
+#include "Physics/SweepAndPrune.h"
+#include "Physics/SpatialHash.h"
+#include "Physics/AABBTree.h"
+#include "Physics/PairSet.h"
+#include "Physics/MortonSort.h"
+#include "Physics/UnionFind.h"
+#include "Physics/BatchColoring.h"
 #include <iostream>
-#include "tinyxml2\tinyxml2.h"
+#include "tinyxml2/tinyxml2.h"
 
 namespace Physebs {
 	class Rigidbody;
@@ -16,32 +41,7 @@ namespace Physebs {
 
 	class Constraint;
 
-	/**
-	*	@brief Structure for holding collision data.
-	*/
-	struct Collision {
-		Collision(Rigidbody* a_actor, Rigidbody* a_other, const glm::vec3& a_collisionNormal = glm::vec3(), float a_overlap = 0.f) 
-			: actor(a_actor), other(a_other), collisionNormal(a_collisionNormal), overlap(a_overlap) {}
-
-	public:
-		Rigidbody* actor;
-		Rigidbody* other;
-
-		float overlap;				// The overlap between the colliding object's shapes
-
-		glm::vec3 collisionNormal;	// The direction to base collision knockback on
-
-		/**
-		*	@brief Swap actor with other to use the main is colliding function in order to avoid duplicate code.
-		*	@return void.
-		*/
-		void SwapObjects() {
-			Rigidbody * tmp = actor;
-
-			actor = other;
-			other = tmp;
-		}
-	};
+	enum eBroadphase {BRUTE_FORCE, OCTREE, LOOSE_OCTREE, SWEEP_AND_PRUNE, SPATIAL_HASH, AABB_TREE, BROADPHASE_COUNT};		// How objects are split up to avoid checking every object against every other object
 
 	/**
 	*	@brief Class that holds onto rigidbody objects and handles their physics (gravity, forces, collisions).
@@ -50,27 +50,35 @@ namespace Physebs {
 	class Scene {
 	public:
 		Scene(const glm::vec3& a_gravityForce = glm::vec3(0, DEFAULT_GRAVITY, 0), const glm::vec3& a_globalForce = glm::vec3(),	 // Default gravity force pushes down
-			const glm::vec3& a_simulationOrigin = glm::vec3(), const glm::vec3& a_simulationHalfExtents = DEFAULT_SIMULATION_HALFEXTENTS);
+			const glm::vec3& a_simulationOrigin = glm::vec3(), const glm::vec3& a_simulationHalfExtents = DEFAULT_SIMULATION_HALFEXTENTS,
+			unsigned int a_threadCount = DEFAULT_THREAD_COUNT);
 		~Scene();
 
 		void FixedUpdate(float a_dt);
 		void Draw();
 		
-		void AddObject(Rigidbody* a_obj);
-		void RemoveObject(Rigidbody* a_obj);
+		template <class T, class... Args>
+		T*	 CreateObject(Args&&... a_args);				// Construct an object (Sphere, Plane or AABB) in the scene's pool for its shape and add it to the scene
+		template <class T, class... Args>
+		std::vector<T*> CreateObjects(size_t a_count, const Args&... a_args);	// Construct many objects of one shape with the same arguments, making room for all of them once
+		void DestroyObject(Rigidbody* a_obj);				// Remove an object and its constraints from the scene and free it back into its pool
+		void DestroyObjects(const std::vector<Rigidbody*>& a_objs);
+		void ReserveObjects(size_t a_count);				// Make room for a total number of objects up front (e.g. before mass spawning)
 
-		void AddConstraint(Constraint* a_constraint);
-		void RemoveConstraint(Constraint* a_constraint);
+		template <class T, class... Args>
+		T*	 CreateConstraint(Args&&... a_args);			// Construct a constraint (Spring) in the scene's pool for its type and add it to the scene
+		void DestroyConstraint(Constraint* a_constraint);
 
-		Rigidbody* GetObjectByID(unsigned int a_id);
+		// NOTE: Creating and destroying during a step (e.g. from a constraint) is queued and applied together once the step is done
+
+		Rigidbody* GetObjectByID(unsigned int a_id) const;
+		Rigidbody* GetObjectByHandle(BodyHandle a_handle) const;
 
 		tinyxml2::XMLError SaveScene(const char* a_fileName);
 		tinyxml2::XMLError LoadScene(const char* a_fileName);
 
 		void ApplyGlobalForce();
 
-		void PartitionCollisions();
-
 		static bool IsColliding_Sphere_Sphere(Collision& a_collision);
 		static bool IsColliding_Sphere_Plane(Collision& a_collision);
 		static bool IsColliding_Sphere_AABB(Collision& a_collision);
@@ -82,37 +90,132 @@ namespace Physebs {
 		static bool IsColliding_AABB_Sphere(Collision& a_collision);
 		static bool IsColliding_AABB_AABB(Collision& a_collision);
 
+		// Batch kernels, return a bit mask of which of the (up to PAIR_BATCH_WIDTH) pairs could be colliding, bit 0 is the first pair
+		static int SphereSphereBatchMask(const BucketPair* a_pairs, size_t a_count);
+		static int BoxBoxBatchMask(const BucketPair* a_pairs, size_t a_count);
+
 		const std::vector<Rigidbody*>& GetObjects()	const				{ return m_objects; }
 		const std::vector<Constraint*>& GetConstraints() const			{ return m_constraints; }
+		const BodyStore&				GetBodyStore() const			{ return m_bodies; }
+		JobSystem*						GetJobSystem()					{ return m_jobSystem; }
 
 		const glm::vec3&	GetGravity() const							{ return m_gravity; }
-		void				SetGravity(const glm::vec3& a_gravity)		{ m_gravity = a_gravity; }
+		void				SetGravity(const glm::vec3& a_gravity);									// Wakes every object if it changes
 
 		const glm::vec3&	GetGlobalForce() const						{ return m_globalForce; }
 		void				SetGlobalForce(const glm::vec3& a_force)	{ m_globalForce = a_force; }
 
-		bool*				GetIsPartitionedRef()						{ return &b_partitionCollisions; }
+		eBroadphase			GetBroadphase() const						{ return m_broadphase; }
+		int*				GetBroadphaseRef()							{ return (int*)&m_broadphase; }			// For picking from a list (e.g. combo box)
+		void				SetBroadphase(eBroadphase a_broadphase)		{ m_broadphase = a_broadphase; }		// Auto selection will change it again if it is on
+
+		bool*				GetIsAutoBroadphaseRef()					{ return &b_autoBroadphase; }
+		float				GetBroadphaseTime(eBroadphase a_broadphase) const	{ return m_broadphaseTimes[a_broadphase]; }		// Milliseconds its refit and pair search last took (auto selection averages over its samples)
+
 		float*				GetTimeStepRef()							{ return &m_fixedTimeStep; }
+		int*				GetSolverIterationsRef()					{ return &m_solverIterations; }	// More iterations settle stacks better (and allow a larger time step) at a higher cost
+
+		bool*				GetAllowSleepRef()							{ return &b_allowSleep; }		// Turning sleeping off wakes every sleeping object on the next step
+
+		DebugDraw*			GetDebugDraw() const						{ return m_debugDraw; }
+		void				SetDebugDraw(DebugDraw* a_debugDraw)		{ m_debugDraw = a_debugDraw; }		// NOTE: Scene does not take ownership of the debug draw sink
 	protected:
 		glm::vec3 m_gravity;
 		glm::vec3 m_globalForce;					// Force that will affect all objects
+		glm::vec3 m_pendingGlobalForce;				// Global force applied since the last step, added in by the next integration
 
-		std::vector<Rigidbody*>		m_objects;
+		std::vector<Rigidbody*>		m_objects;		// Same order as the body store (index = store index), removal swaps the last object into the hole
+		std::vector<Plane*>			m_planes;		// Planes move by distance from origin so need fixing up after integration
+		BodyStore					m_bodies;		// Contiguous physics state of every object, swept by the per-body passes
 		std::vector<Constraint*>	m_constraints;	// Hold onto all constraints between objects
+		SpringStore					m_springs;		// Contiguous attributes of every spring constraint, swept by the spring kernel
+		std::vector<Constraint*>	m_activeConstraints;	// Constraints with an awake object to move this step, in scene order
+		BatchColoring				m_constraintBatches;	// Active constraints split into batches where no two move the same object
+
+		std::vector<std::vector<Constraint*>>			m_objectConstraints;	// Constraints attached to each object, same order as the objects
+		std::unordered_multimap<unsigned int, Rigidbody*>	m_idLookup;			// Objects with each ID, IDs can be shared (e.g. loaded from file or set by hand)
+
+		/**
+		*	@brief Entry of the handle map, the object using it or the next free entry while unused.
+		*/
+		struct HandleSlot {
+			Rigidbody*		obj;
+			unsigned int	generation;
+			unsigned int	nextFree;
+		};
+
+		std::vector<HandleSlot>	m_handleSlots;
+		unsigned int			m_freeHandleSlot = ~0u;		// First unused entry, ~0u if there are none
+
+		enum eSceneCommand { ADD_OBJECT, DESTROY_OBJECT, ADD_CONSTRAINT, DESTROY_CONSTRAINT, DISCARD_CONSTRAINT };	// Discarded constraints were made on objects already queued for destruction, they are freed without ever being added
+
+		/**
+		*	@brief Structural change made during a step, applied in order with the rest once the step is done.
+		*/
+		struct SceneCommand {
+			eSceneCommand	type;
+			Rigidbody*		obj;
+			Constraint*		constraint;
+		};
+
+		std::vector<SceneCommand>	m_commands;
+		bool						b_inStep = false;		// Whether a step is running, structural changes are queued while it is
+
+		// Every object and constraint in the scene is allocated from these, one pool per type
+		std::tuple<ObjectPool<Sphere>, ObjectPool<Plane>, ObjectPool<AABB>, ObjectPool<Spring>> m_pools;
 		std::vector<Collision>		m_collisions;	// Hold onto all collisions that have occured in the frame for collision resolution
 
-		bool b_partitionCollisions = true;			// Whether octal space partitioning is used to detect collisions. (ON BY DEFAULT)
+		eBroadphase m_broadphase = LOOSE_OCTREE;	// How collision checks are narrowed down to objects that could be touching
+		int			m_refitBroadphase = BROADPHASE_COUNT;	// Broadphase refit or rebuilt last step, any other is behind on objects that have fallen asleep since
+
+		bool						b_allowSleep = true;	// Whether islands of objects that have come to rest are put to sleep
+		UnionFind					m_islandSets;			// Objects that touched or are constrained together this step, by store index
+		std::vector<unsigned int>	m_islandRoots;			// Island each object is in (its root in the union find)
+		std::vector<float>			m_islandRest;			// Shortest rest time of each island's awake objects, by root
+		std::vector<unsigned int>	m_sleepingBodies;		// Objects of islands falling asleep this step, grouped by island
+
+		bool			b_autoBroadphase = false;								// Whether the broadphase is periodically switched to whichever was cheapest for the current scene
+		int				m_autoCandidate = BROADPHASE_COUNT;						// Broadphase being sampled by auto selection, BROADPHASE_COUNT when not sampling
+		unsigned int	m_autoStep = BROADPHASE_AUTO_INTERVAL;					// Steps spent sampling the candidate or since the last selection (starts due so turning auto on samples straight away)
+		float			m_autoTimeSum = 0.f;									// Time the candidate took over the counted samples
+		float			m_broadphaseTimes[BROADPHASE_COUNT] = {};
+
+		JobSystem* m_jobSystem = nullptr;			// Threads per-body and per-pair loops are split across
+
+		DebugDraw* m_debugDraw = nullptr;			// Where Draw sends debug geometry, nothing is drawn if null (e.g. headless)
 
 		// Fixed Update variables
 		float m_fixedTimeStep;														// The fixed time between updates of the scene
 		float m_accumulatedTime;													// How much time overflow there is between fixed updates
 	private:
 		void Update();																// Update functionality with fixed time step
-		void ApplyGravity();														// Only want scene to be able to apply gravity to keep consistency
-		void DetectCollisions(const std::vector<Rigidbody*>& a_objects);			// Object collisions are only handled within the scene
-		void ResolveCollisions();													// Apply appropriate forces to objects that have collided
-		void ApplyKnockback_Dynamic(Collision& a_collision);
-		void ApplyKnockback_Static(Collision& a_collision);
+		void AddObject(Rigidbody* a_obj);											// Start simulating a newly created object
+		void RemoveObject(Rigidbody* a_obj);										// Stop simulating an object, destroying its constraints (its memory stays with its pool)
+		void AddConstraint(Constraint* a_constraint);
+		void RemoveConstraint(Constraint* a_constraint);
+		void FreeConstraint(Constraint* a_constraint);								// Give a constraint's memory back to the pool for its type
+		void SetObjectID(Rigidbody* a_obj, unsigned int a_id);						// Change an object's ID, keeping the ID lookup in step
+		void RemoveIDLookup(Rigidbody* a_obj);										// Take an object out of the ID lookup, leaving other objects with the same ID in it
+		void ReleaseHandles();														// Make every handle stale at once, for when every object is dropped
+		void FlushCommands();														// Apply the structural changes queued during the step
+		void PartitionCollisions();
+		void BroadphaseCollisions(eBroadphase a_broadphase);
+		void CullObjects();															// Queue destroying every object outside of the simulation boundaries, for the loose octree
+		void UpdateConstraints();													// Apply every constraint's forces, a batch of constraints that don't share objects at a time
+		void UpdateSprings();														// Apply every spring's force with the spring kernel
+		void IntegrateBodies();														// Apply gravity and pending forces then integrate velocity and position of every dynamic object in the body store
+		void DetectCollision(Rigidbody* a_actor, Rigidbody* a_other,				// Check a single pair of objects with the appropriate colliding check for their shapes
+			std::vector<Collision>& a_collisions);
+		void DetectPairCollisions(const std::vector<CollisionPair>& a_pairs,		// Narrowphase over the pairs a broadphase found
+			std::vector<Collision>& a_collisions);
+		void DetectPlaneCollisions(const Broadphase* a_broadphase,					// Check every plane against the non-plane objects that could be touching it (planes are infinite so broadphases skip them)
+			std::vector<Collision>& a_collisions);
+		void GatherPlaneCandidates();												// Copy the plane candidates' positions and sizes side by side for the batched plane check
+		void UpdateAutoBroadphase();												// Sample each broadphase's cost in turn and settle on the cheapest
+		int	 NextAutoCandidate(int a_after) const;									// Next broadphase auto selection can sample, BROADPHASE_COUNT if there are none left
+		void WakeTouchedIslands();													// Wake sleeping islands hit by objects that are still settling
+		void ResolveCollisions();													// Solve the contacts between objects that have collided
+		void UpdateIslands();														// Group objects into islands and put the ones that have come to rest to sleep
 
 #pragma region Spatial Partitioning
 		/**
@@ -125,46 +228,122 @@ namespace Physebs {
 				debugColor = glm::vec4(1, 0, 0, 1.f);
 			}
 
-			Scene*					scene = nullptr;						// What scene contained objects are apart of
-			glm::vec4				debugColor;								// What color to draw contained objects in.
-			std::vector<Rigidbody*> containedObjects;						// List of pointers to object that are inside the partition volume
+			// Called by the octree when it reuses the node for a new build
+			void clear() {
+				scene = nullptr;
+				firstKey = 0;
+				keyCount = 0;
+			}
+
+			Scene*			scene = nullptr;					// What scene contained objects are apart of
+			glm::vec4		debugColor;							// What color to draw contained objects in.
+			unsigned int	firstKey = 0;						// Range of the sorted partition keys in this volume, each refers to an object whose bounds overlap it
+			unsigned int	keyCount = 0;
+		};
+
+		/**
+		*	@brief Object added to the octree this step along with its bounds.
+		*/
+		struct PartitionEntry {
+			Rigidbody*		obj;
+			glm::vec3		min;
+			glm::vec3		max;
+			unsigned int	cellMin[3];		// Range of smallest volumes the bounds overlap, as octree grid coordinates
+			unsigned int	cellMax[3];
+			size_t			firstKey;		// Where the entry's keys start, one per overlapped volume
+		};
+
+		/**
+		*	@brief Two partition entries with overlapping bounds, found in a volume they share.
+		*/
+		struct PartitionPair {
+			unsigned int first;
+			unsigned int second;
+		};
+
+		/**
+		*	@brief Objects that could be touching a plane, with their positions and sizes side by side so they can be checked against it in batches.
+		*	NOTE: The lists are padded to a multiple of SIMD_WIDTH with entries that never touch a plane.
+		*/
+		struct PlaneCandidates {
+			std::vector<Rigidbody*>	objs;
+			std::vector<float>		x;
+			std::vector<float>		y;
+			std::vector<float>		z;
+			std::vector<float>		radius;				// 0 for boxes
+			std::vector<float>		halfX;				// Half extents, 0 for spheres
+			std::vector<float>		halfY;
+			std::vector<float>		halfZ;
 		};
 
 	public:
 		Octree<PartitionNode>*	GetPartitionTree() { return m_spatialPartitionTree; }
+		Broadphase*				GetBroadphase(eBroadphase a_broadphase) { return m_broadphases[a_broadphase]; }		// Null for the octree, it is rebuilt from the scene each step instead
+		LooseOctree*			GetLooseTree() { return static_cast<LooseOctree*>(m_broadphases[LOOSE_OCTREE]); }
+		SweepAndPrune*			GetSweepAndPrune() { return static_cast<SweepAndPrune*>(m_broadphases[SWEEP_AND_PRUNE]); }
+		SpatialHash*			GetSpatialHash() { return static_cast<SpatialHash*>(m_broadphases[SPATIAL_HASH]); }
+		AABBTree*				GetAABBTree() { return static_cast<AABBTree*>(m_broadphases[AABB_TREE]); }
 
 	private:
 		Octree<PartitionNode>*	m_spatialPartitionTree = nullptr;
+		Broadphase*				m_broadphases[BROADPHASE_COUNT] = {};		// Persistent, objects are added and removed along with the scene's so switching between them is free
+
+		std::vector<PartitionEntry>			m_partitionEntries;			// Objects added to the octree this step, volumes refer to them by index
+		std::vector<MortonEntry>			m_partitionKeys;			// One per volume each object overlaps, sorted so each volume's objects are next to each other
+		MortonSorter						m_partitionSorter;
+		std::vector<PartitionPair>			m_partitionPairs;			// Pairs found in each volume, objects sharing several volumes are found once per volume
+		std::vector<std::vector<PartitionPair>>	m_threadPartitionPairs;	// Per-thread pair buffers (capacity is reused between steps)
+		PairSet								m_partitionPairSet;			// Drops the pairs found in more than one volume
+		std::vector<CollisionPair>			m_collisionPairs;			// Pairs found by the broadphase each step
+		std::vector<std::vector<Collision>>	m_threadCollisions;			// Per-thread contact buffers (capacity is reused between steps)
+		PlaneCandidates						m_planeCandidates;			// Objects near the plane being checked
 
 		/**
-		*	@brief Inherited callback class used for detecting collisions with contained objects in a partition volume in an octree.
+		*	@brief Octree leaf visitor used for finding the objects with overlapping bounds in a partition volume.
+		*	NOTE: Only reads scene state so can be called concurrently as long as each call has its own pair list.
 		*/
-		class OctreeCallbackDetectCollisions : public Octree<PartitionNode>::Callback {
+		class OctreeVisitorFindPairs {
 
-			virtual bool operator()(const float min[3], const float max[3], PartitionNode& nodeData) {
-				// Only detect collisions in a volume with an initialised scene
-				if (nodeData.scene == nullptr) {
-					// Volume scene is null but there might be other volumes that are initialised
-					return true;
-				}
+		public:
+			OctreeVisitorFindPairs(const Scene* a_scene) : scene(a_scene) {}
 
-				// Call detect collisions in the scene with the contained objects in the volume
-				nodeData.scene->DetectCollisions(nodeData.containedObjects);
+			const Scene* scene;
 
-				// Continue to detect collisions in the rest of the octree volumes
-				return true;
+			bool operator()(const float min[3], const float max[3], PartitionNode& nodeData, std::vector<PartitionPair>& pairs) const {
+				const MortonEntry* contained = &scene->m_partitionKeys[nodeData.firstKey];
+
+				for (unsigned int i = 0; i < nodeData.keyCount; ++i) {
+					const PartitionEntry& entry = scene->m_partitionEntries[contained[i].index];
+
+					for (unsigned int j = i + 1; j < nodeData.keyCount; ++j) {
+						const PartitionEntry& other = scene->m_partitionEntries[contained[j].index];
+
+						if (entry.min.x <= other.max.x && entry.max.x >= other.min.x &&
+							entry.min.y <= other.max.y && entry.max.y >= other.min.y &&
+							entry.min.z <= other.max.z && entry.max.z >= other.min.z)
+						{
+							pairs.push_back(PartitionPair{ contained[i].index, contained[j].index });
+						}
+					}
+				}
 
+				// Continue to the rest of the octree volumes
+				return true;
 			}
 		};
 
 		/**
-		*	@brief Inherited callback class used for drawing an AABB for each partition volume in octree.
+		*	@brief Octree visitor used for drawing an AABB for each partition volume in octree.
 		**/
-		class OctreeCallbackDebug : public Octree<PartitionNode>::Callback {
+		class OctreeVisitorDebug {
 
 		public:
-			// Override callback operator called for every octree node. NOTE: If function returns false, traversal will be broken early
-			virtual bool operator()(const float min[3], const float max[3], PartitionNode& nodeData) {
+			OctreeVisitorDebug(DebugDraw* a_debugDraw) : debugDraw(a_debugDraw) {}
+
+			DebugDraw* debugDraw;
+
+			// Called for every octree node. NOTE: If function returns false, the node's subcells are skipped
+			bool operator()(const float min[3], const float max[3], PartitionNode& nodeData) const {
 				// Calculate extents and pos to draw AABB representative of current octree volume
 				glm::vec3 currentMin = glm::vec3(min[0], min[1], min[2]);
 				glm::vec3 currentMax = glm::vec3(max[0], max[1], max[2]);
@@ -172,7 +351,7 @@ namespace Physebs {
 				glm::vec3 pos = (currentMin + currentMax) / 2.f;
 				glm::vec3 halfExtents = (currentMax - currentMin) / 2.f;
 
-				aie::Gizmos::addAABB(pos, halfExtents, nodeData.debugColor);
+				debugDraw->AddAABB(pos, halfExtents, nodeData.debugColor);
 
 				// Make AABBs for the rest of the octree volumes
 				return true;
@@ -180,6 +359,147 @@ namespace Physebs {
 		};
 #pragma endregion
 
-	
+#pragma region Contact Solver
+		/**
+		*	@brief Pair of object handles a contact's impulse is cached under, the handle with the lower slot first so the pair gives the same key either way round.
+		*	NOTE: Handles include their generation, so an object reusing a destroyed object's slot doesn't warm start from the destroyed object's contacts.
+		*/
+		struct ContactKey {
+			uint64_t	first;		// Generation << 32 | slot
+			uint64_t	second;
+
+			bool operator==(const ContactKey& a_other) const	{ return first == a_other.first && second == a_other.second; }
+		};
+
+		struct ContactKeyHash {
+			size_t operator()(const ContactKey& a_key) const	{ return std::hash<uint64_t>()(a_key.first * 0x9E3779B97F4A7C15ull ^ a_key.second); }
+		};
+
+		/**
+		*	@brief Collision being resolved by the solver, refers to its objects by store index so the solver works on the body store directly.
+		*/
+		struct SolverContact {
+			unsigned int	actor;
+			unsigned int	other;
+			glm::vec3		normal;				// Unit length, from actor to other
+			float			overlap;
+			float			actorInvMass;		// 0 for static and sleeping objects
+			float			otherInvMass;
+			float			normalMass;			// Mass the contact's impulse moves, 1 / (actorInvMass + otherInvMass)
+			float			targetVel;			// Separating velocity to solve for, from the objects' restitution
+			float			impulse;			// Impulse applied so far, warm started from the last step
+			ContactKey		key;
+		};
+
+		std::vector<SolverContact>				m_contacts;
+		BatchColoring							m_contactBatches;		// Contacts split into batches where no two move the same object
+		std::unordered_map<ContactKey, float, ContactKeyHash>	m_contactCache;			// Impulse each pair of objects ended the last step with
+		std::unordered_map<ContactKey, float, ContactKeyHash>	m_nextContactCache;		// Filled in by this step, swapped with the cache to keep both tables' memory
+		int										m_solverIterations = DEFAULT_SOLVER_ITERATIONS;
+
+		void PrepareContacts();													// Turn the collisions into solver contacts, warm starting from the contact cache
+		void ApplyContactImpulse(const SolverContact& a_contact, float a_impulse);
+		void SolveContact(SolverContact& a_contact);							// One solver pass over a contact
+		void CorrectContactPositions();											// Push overlapping objects apart
+#pragma endregion
+
+#pragma region Narrowphase
+		std::vector<BucketPair>		m_pairBuckets[SHAPE_COUNT * SHAPE_COUNT];	// One per combination of shapes (actor shape * SHAPE_COUNT + other shape), pairs are swapped into the order that has a colliding check
+		std::vector<Collision>		m_pairCollisions;							// Result of each broadphase pair in the same order, a null actor means the pair wasn't colliding
+
+		template <size_t... Buckets>
+		void DetectBucketCollisions(std::index_sequence<Buckets...>);			// Check every bucket, one loop generated per combination of shapes
+		template <eShape Actor, eShape Other>
+		void DetectBucketCollisions();											// Check every pair in a bucket, only for pairs its batch kernel passes
+#pragma endregion
 	};
-}
\ No newline at end of file
+
+	/**
+	*	@brief Construct an object in the pool for its type and add it to the scene, the scene is responsible for it from now on.
+	*	NOTE: During a step the object is only added once the step is done.
+	*	@param a_args are passed on to the object's constructor.
+	*	@return Pointer to the new object, valid until it is destroyed, culled or the scene is reloaded.
+	*/
+	template <class T, class... Args>
+	T* Scene::CreateObject(Args&&... a_args)
+	{
+		T* obj = std::get<ObjectPool<T>>(m_pools).Create(std::forward<Args>(a_args)...);
+
+		if (b_inStep) {
+			m_commands.push_back(SceneCommand{ ADD_OBJECT, obj, nullptr });
+		}
+		else {
+			AddObject(obj);
+		}
+
+		return obj;
+	}
+
+	/**
+	*	@brief Construct a number of objects in the pool for their type and add them to the scene in one pass, the scene is responsible for them from now on.
+	*	The pool, handle map, body store and broadphase lists are grown once up front instead of as each object is added.
+	*	NOTE: Every object is constructed with the same arguments, move them into place afterwards (e.g. SetPos). During a step they are only added once the step is done.
+	*	@param a_count is how many objects to create.
+	*	@param a_args are passed on to every object's constructor.
+	*	@return Pointers to the new objects in the order they were added, valid until they are destroyed, culled or the scene is reloaded.
+	*/
+	template <class T, class... Args>
+	std::vector<T*> Scene::CreateObjects(size_t a_count, const Args&... a_args)
+	{
+		ObjectPool<T>& pool = std::get<ObjectPool<T>>(m_pools);
+		pool.Reserve(a_count);
+
+		if (b_inStep) {
+			m_commands.reserve(m_commands.size() + a_count);
+		}
+		else {
+			ReserveObjects(m_objects.size() + a_count);
+		}
+
+		std::vector<T*> objs;
+		objs.reserve(a_count);
+
+		for (size_t i = 0; i < a_count; ++i) {
+			T* obj = pool.Create(a_args...);
+
+			if (b_inStep) {
+				m_commands.push_back(SceneCommand{ ADD_OBJECT, obj, nullptr });
+			}
+			else {
+				AddObject(obj);
+			}
+
+			objs.push_back(obj);
+		}
+
+		return objs;
+	}
+
+	/**
+	*	@brief Construct a constraint in the pool for its type and add it to the scene, the scene is responsible for it from now on.
+	*	NOTE: During a step the constraint is only added once the step is done, or freed then if one of its objects was destroyed earlier in the step.
+	*	@param a_args are passed on to the constraint's constructor.
+	*	@return Pointer to the new constraint, valid until it or one of its objects is destroyed or the scene is reloaded.
+	*/
+	template <class T, class... Args>
+	T* Scene::CreateConstraint(Args&&... a_args)
+	{
+		T* constraint = std::get<ObjectPool<T>>(m_pools).Create(std::forward<Args>(a_args)...);
+
+		if (b_inStep) {
+			// An object queued for destruction is freed before the constraint would be added, so the constraint goes with it
+			if (constraint->GetAttachedActor()->b_destroyQueued || constraint->GetAttachedOther()->b_destroyQueued) {
+				constraint->b_destroyQueued = true;
+				m_commands.push_back(SceneCommand{ DISCARD_CONSTRAINT, nullptr, constraint });
+			}
+			else {
+				m_commands.push_back(SceneCommand{ ADD_CONSTRAINT, nullptr, constraint });
+			}
+		}
+		else {
+			AddConstraint(constraint);
+		}
+
+		return constraint;
+	}
+}
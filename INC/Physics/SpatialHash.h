@@ -0,0 +1,78 @@
+#pragma once
+
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+#include <glm/vec3.hpp>
+#include "PhysebsUtility_Literals.h"
+#include "Physics/Broadphase.h"
+
+namespace Physebs {
+	class Rigidbody;
+	class JobSystem;
+
+	/**
+	*	@brief Uniform grid broadphase hashed into a flat open-addressing table keyed by the Morton code of each cell.
+	*	Every object is added to each cell its bounds touch, the table and cell lists are rebuilt every step but their memory is kept.
+	*	Cells are only created where there are objects, so the grid is unbounded and nothing is culled.
+	*	Suits many objects of a similar size, cell size should be around the size of the largest common object.
+	*	NOTE: Objects covering more than SPATIAL_HASH_MAX_OBJECT_CELLS cells (e.g. large walls) are kept out of the grid and checked against every object.
+	*	NOTE: Planes are infinite and are never inserted, check them against every object separately.
+	*/
+	class SpatialHash : public Broadphase {
+	public:
+		SpatialHash(float a_cellSize = SPATIAL_HASH_CELL_SIZE);
+
+		virtual void Insert(Rigidbody* a_obj);
+		virtual void Remove(Rigidbody* a_obj);
+		virtual void Clear();
+
+		virtual void Refit(JobSystem* a_jobSystem, bool a_skipAsleep);
+		virtual void FindPairs(JobSystem* a_jobSystem, std::vector<CollisionPair>& a_pairs);
+
+		float			GetCellSize() const					{ return m_cellSize; }
+		void			SetCellSize(float a_cellSize)		{ m_cellSize = a_cellSize; }		// Takes effect on the next refit
+
+		virtual size_t	GetObjectCount() const				{ return m_entries.size(); }
+		unsigned int	GetOccupiedCellCount() const		{ return m_occupiedCellCount; }
+	protected:
+		/**
+		*	@brief Object held by the grid along with its bounds and the range of cells they touched as of the last refit.
+		*/
+		struct Entry {
+			Rigidbody*	obj;
+			glm::vec3	min;
+			glm::vec3	max;
+			glm::ivec3	cellMin;
+			glm::ivec3	cellMax;
+			bool		b_oversized;		// Touches too many cells to be put in the grid
+		};
+
+		/**
+		*	@brief Table slot for an occupied cell, its objects are [begin, begin + count) of the cell entry list.
+		*/
+		struct Slot {
+			uint64_t		key;
+			unsigned int	begin;
+			unsigned int	count;
+		};
+
+		std::vector<Entry>							m_entries;
+		std::unordered_map<Rigidbody*, unsigned int> m_entryLookup;		// Object to entry index
+
+		std::vector<Slot>							m_table;			// Power of two sized, linear probing
+		unsigned int								m_tableShift = 64;	// 64 - log2(table size), for turning a hash into a slot index
+		std::vector<unsigned int>					m_cellEntries;		// Entry indices grouped by cell
+
+		float			m_cellSize;
+
+		unsigned int	m_occupiedCellCount = 0;
+
+		std::vector<std::vector<CollisionPair>>		m_threadPairs;		// Per-thread pair buffers (capacity is reused between steps)
+	private:
+		static uint64_t CellKey(int a_x, int a_y, int a_z);
+
+		unsigned int	FindSlot(uint64_t a_key) const;
+		Slot&			FindOrAddSlot(uint64_t a_key);
+	};
+}
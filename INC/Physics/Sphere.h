@@ -1,6 +1,6 @@
 #pragma once
 
-#include "Physics\Rigidbody.h"
+#include "Physics/Rigidbody.h"
 #include <glm/vec2.hpp>
 
 namespace Physebs {
@@ -14,7 +14,9 @@ namespace Physebs {
 		
 		virtual ~Sphere();
 
-		virtual void Draw();
+		virtual void Draw(DebugDraw* a_debugDraw);
+
+		virtual void CalculateBounds(glm::vec3& a_min, glm::vec3& a_max) const;
 
 		float*				GetRadiusRef() 									{ return &m_radius; }
 		float				GetRadius() const								{ return m_radius; }
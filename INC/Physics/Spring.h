@@ -1,8 +1,14 @@
 #pragma once
 
 #include "Physics/Constraint.h"
+#include "Physics/SpringStore.h"
 
 namespace Physebs {
+	/**
+	*	@brief Constraint pulling or pushing two objects towards a resting length apart (Hooke's law), with dampening on their relative velocity.
+	*	NOTE: Once added to a scene the spring's attributes live in the scene's SpringStore and the Spring becomes a view over its slot,
+	*	the scene then evaluates every spring at once with a batched kernel rather than through Constrain.
+	*/
 	class Spring : public Constraint {
 	public:
 		Spring(Rigidbody* a_attachedActor, Rigidbody* a_attachedOther, const glm::vec4& a_color = DEFAULT_CONSTRAINT_COLOR,
@@ -10,20 +16,32 @@ namespace Physebs {
 		~Spring();
 
 		virtual void Constrain();
-		virtual void Draw();
+		virtual void Draw(DebugDraw* a_debugDraw);
 
-		float	GetSpringiness() const	{ return m_springiness; }
-		float*	GetSpringinessRef()		{ return &m_springiness; }
+		float	GetSpringiness() const	{ return m_store ? m_store->springiness[m_storeIndex] : m_springiness; }
+		float*	GetSpringinessRef()		{ return &SpringinessData(); }
 		
-		float	GetRestLength() const	{ return m_restLength; }
-		float*	GetRestLengthRef()		{ return &m_restLength; }
+		float	GetRestLength() const	{ return m_store ? m_store->restLength[m_storeIndex] : m_restLength; }
+		float*	GetRestLengthRef()		{ return &RestLengthData(); }
 		
-		float	GetDampening() const	{ return m_springDampening; }
-		float*	GetDampeningRef()		{ return &m_springDampening; }
+		float	GetDampening() const	{ return m_store ? m_store->dampening[m_storeIndex] : m_springDampening; }
+		float*	GetDampeningRef()		{ return &DampeningData(); }
+
+		unsigned int GetStoreIndex() const	{ return m_storeIndex; }		// NOTE: Only meaningful while owned by a scene, changes when other springs are removed
 	protected:
+		friend struct SpringStore;	// Store moves the attributes in and out of the spring when it is added or removed from a scene
+
+		// Attributes used while the spring is not owned by a scene (see SpringStore)
 		float m_springiness;		// Scale of force to apply to attached rigidbodies
 		float m_restLength;			// Distance attached rigidbodies must be at before being constrained
 		float m_springDampening;	// How quickly energy from spring dissipates
+
+		SpringStore*	m_store			= nullptr;		// Scene store holding the attributes, null if not owned by a scene
+		unsigned int	m_storeIndex	= 0;
 	private:
+		// Resolve where the attributes currently live (scene store slot or local fallback)
+		float&	SpringinessData()	{ return m_store ? m_store->springiness[m_storeIndex] : m_springiness; }
+		float&	RestLengthData()	{ return m_store ? m_store->restLength[m_storeIndex] : m_restLength; }
+		float&	DampeningData()		{ return m_store ? m_store->dampening[m_storeIndex] : m_springDampening; }
 	};
 }
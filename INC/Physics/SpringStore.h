@@ -0,0 +1,40 @@
+#pragma once
+
+#include <vector>
+#include <glm/vec3.hpp>
+
+namespace Physebs {
+	class Spring;
+
+	/**
+	*	@brief Structure-of-arrays storage for every Spring owned by a scene, so springs are evaluated by a kernel sweeping contiguous memory instead of a virtual call each.
+	*	Every array is indexed by the spring's store index, attached objects are referred to by their body store index.
+	*	NOTE: Removing a spring moves the last spring into the freed slot, store indices are NOT stable across removals.
+	*/
+	struct SpringStore {
+		unsigned int	Add(Spring* a_spring);
+		void			Remove(Spring* a_spring);
+		void			UpdateBodies(Spring* a_spring);			// Pick up new body store indices of the spring's objects after a body moved in its store
+		void			Clear();
+		void			Reserve(size_t a_count);
+
+		void			BuildBodySprings(size_t a_bodyCount);	// Group spring ends by body for summing forces per body
+
+		size_t			Size() const		{ return owners.size(); }
+
+		std::vector<unsigned int>	actor;			// Body store index of each end
+		std::vector<unsigned int>	other;
+
+		std::vector<float>			springiness;
+		std::vector<float>			restLength;
+		std::vector<float>			dampening;
+
+		std::vector<glm::vec3>		force;			// Force on the other end from the last evaluation, the actor gets the negative
+
+		std::vector<Spring*>		owners;			// Which Spring is viewing each slot, used to patch store indices when slots move
+
+		std::vector<unsigned int>	bodyStarts;		// Where each body's spring ends start in bodySprings, with the end of the last body on the end
+		std::vector<unsigned int>	bodySprings;	// Spring ends grouped by body in spring order, store index * 2 + 1 for the other end
+		bool						b_bodySpringsDirty = true;	// Whether springs or their bodies changed since the ends were last grouped
+	};
+}
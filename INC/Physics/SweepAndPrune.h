@@ -0,0 +1,67 @@
+#pragma once
+
+#include <vector>
+#include <unordered_map>
+#include <glm/vec3.hpp>
+#include "PhysebsUtility_Literals.h"
+#include "Physics/Broadphase.h"
+
+namespace Physebs {
+	class Rigidbody;
+	class JobSystem;
+
+	/**
+	*	@brief Sweep and prune broadphase, keeps the interval endpoints of every object's bounds along one axis sorted between steps.
+	*	Objects barely move between steps so the endpoints are re-sorted with an insertion sort, which is close to linear when little has changed.
+	*	Objects whose intervals overlap on the sweep axis are then checked on the other two axes.
+	*	NOTE: Planes are infinite and are never inserted, check them against every object separately.
+	*/
+	class SweepAndPrune : public Broadphase {
+	public:
+		SweepAndPrune(unsigned int a_axis = SAP_AXIS);
+
+		virtual void Insert(Rigidbody* a_obj);
+		virtual void Remove(Rigidbody* a_obj);
+		virtual void Clear();
+
+		virtual void Refit(JobSystem* a_jobSystem, bool a_skipAsleep);
+		virtual void FindPairs(JobSystem* a_jobSystem, std::vector<CollisionPair>& a_pairs);
+
+		virtual size_t	GetObjectCount() const		{ return m_entries.size() - m_removedCount; }
+		unsigned int	GetSwapCount() const		{ return m_swapCount; }		// How many endpoint swaps the last refit's sort needed
+	protected:
+		/**
+		*	@brief Object held by the broadphase along with its bounds as of the last refit.
+		*/
+		struct Entry {
+			Rigidbody*	obj;
+			glm::vec3	min;
+			glm::vec3	max;
+		};
+
+		/**
+		*	@brief Start or end of an entry's interval on the sweep axis.
+		*/
+		struct Endpoint {
+			float			value;
+			unsigned int	entry;
+			bool			b_max;		// Whether this is the end of the interval
+		};
+
+		std::vector<Entry>							m_entries;			// Removed objects leave an entry with a null object until the next refit purges it
+		std::vector<Endpoint>						m_endpoints;		// Sorted by value after every refit (starts before ends when equal)
+		std::unordered_map<Rigidbody*, unsigned int> m_entryLookup;		// Object to entry index
+
+		unsigned int	m_axis;
+
+		unsigned int	m_swapCount = 0;
+		unsigned int	m_removedCount = 0;			// Entries removed since the last refit
+
+		std::vector<unsigned int>					m_entryRemap;		// Where each entry moves to when purging removed ones (capacity is reused)
+
+		std::vector<std::vector<CollisionPair>>		m_threadPairs;		// Per-thread pair buffers (capacity is reused between steps)
+	private:
+		void	SortEndpoints();
+		void	PurgeRemoved();
+	};
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <vector>
+#include <cstddef>
+
+namespace Physebs {
+	/**
+	*	@brief Disjoint sets of indices, used to group bodies that touch or are constrained together into islands.
+	*	Sets are joined by size and paths are halved while finding, so both are close to O(1). Resetting keeps the memory.
+	*/
+	class UnionFind {
+	public:
+		void			Reset(size_t a_count);									// Put every index from 0 to count - 1 in a set of its own
+		unsigned int	Find(unsigned int a_index);								// Index representing the set the given index is in
+		void			Union(unsigned int a_first, unsigned int a_second);		// Join the sets the two indices are in
+
+		size_t			GetCount() const		{ return m_parents.size(); }
+	protected:
+		std::vector<unsigned int>	m_parents;		// Roots are their own parent
+		std::vector<unsigned int>	m_sizes;		// Only kept up to date for roots
+	};
+}
@@ -8,6 +8,7 @@ namespace Physebs {
 	class Scene;
 }
 class Camera;
+class GizmosDebugDraw;
 
 class _2018_02_06_PhysicsEngineApp : public aie::Application {
 public:
@@ -31,5 +32,6 @@ protected:
 
 	// Physics
 	Physebs::Scene*		m_scene		= nullptr;
+	GizmosDebugDraw*	m_debugDraw = nullptr;
 
 };
\ No newline at end of file
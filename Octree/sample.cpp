@@ -40,6 +40,7 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <iomanip>
 #include <math.h>
 #include <stdlib.h>
+#include <chrono>
 using namespace std;
 
 // Any 3D vector implementation can be used, as long as it can be converted
@@ -72,9 +73,12 @@ struct Particle
 struct Node
 {
     vector<Particle*> particles;
+    // Called when the octree reuses the node for a new build, keeps the list's capacity.
+    void clear() { particles.clear(); }
 };
 
 #define NUM_PARTICLES 10000000
+#define NUM_BUILDS 5
 #define R 0.01f
 #define EPSILON 0.0001f
 
@@ -113,6 +117,94 @@ public:
     }
 };
                 
+// Counts every particle in the octree, used to time visiting every node through a virtual callback.
+class CallbackCount: public Octree<Node>::Callback
+{
+public:
+    size_t count;
+    virtual bool operator()(const float min[3], const float max[3], Node& n)
+    {
+        count += n.particles.size();
+        return true;
+    }
+};
+
+// Add all particles to the octree, returns how long it took in milliseconds.
+double buildOctree(Octree<Node>& octree, vector<Particle>& particles)
+{
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    for (size_t i = 0; i < particles.size(); i++)
+    {
+        Node& n = octree.getCell(particles[i].pos);
+        n.particles.push_back(&particles[i]);
+    }
+    return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+}
+
+// Compare rebuilding the octree from scratch with clearing and rebuilding the same one (like a physics step does every frame).
+void benchmarkBuilds(vector<Particle>& particles, float cellSize)
+{
+    float min[3] = {0.0f, 0.0f, 0.0f};
+    float max[3] = {1.0f + EPSILON, 1.0f + EPSILON, 1.0f + EPSILON};
+    float cell[3] = {cellSize, cellSize, cellSize};
+
+    cout << "Minimum cell size " << cellSize << ", average of " << NUM_BUILDS << " builds:" << endl;
+
+    // New octree every build, every node and particle list is allocated and then freed
+    double freshTime = 0.0;
+    for (int i = 0; i < NUM_BUILDS; i++)
+    {
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        {
+            Octree<Node> octree(min, max, cell);
+            buildOctree(octree, particles);
+        }
+        freshTime += chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+    }
+
+    // Same octree every build, clear() keeps the nodes and their particle lists' capacity
+    Octree<Node> octree(min, max, cell);
+    buildOctree(octree, particles);
+    double reuseTime = 0.0;
+    for (int i = 0; i < NUM_BUILDS; i++)
+    {
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        octree.clear();
+        buildOctree(octree, particles);
+        reuseTime += chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+    }
+
+    // Visit every node, counting particles (the work per node is tiny so this is mostly traversal overhead)
+    CallbackCount callbackCount;
+    callbackCount.count = 0;
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    octree.traverse(&callbackCount);
+    double traverseTime = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+
+    size_t visitCount = 0;
+    start = chrono::steady_clock::now();
+    octree.visit([&visitCount](const float min[3], const float max[3], Node& n) { visitCount += n.particles.size(); return true; });
+    double visitTime = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+
+    size_t leavesCount = 0;
+    start = chrono::steady_clock::now();
+    octree.visitLeaves([&leavesCount](const float min[3], const float max[3], Node& n) { leavesCount += n.particles.size(); return true; });
+    double leavesTime = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+
+    assert(callbackCount.count == particles.size() && visitCount == particles.size() && leavesCount == particles.size());
+
+    cout << fixed << setprecision(1);
+    cout << "  Nodes: " << octree.GetNodeCount() << endl;
+    cout << "  New octree:    " << freshTime / NUM_BUILDS << "ms" << endl;
+    cout << "  Reused octree: " << reuseTime / NUM_BUILDS << "ms (" << freshTime / reuseTime << "x)" << endl;
+    cout << setprecision(3);
+    cout << "  Traverse every node, virtual callback: " << traverseTime << "ms" << endl;
+    cout << "  Visit every node, templated visitor:   " << visitTime << "ms" << endl;
+    cout << "  Visit only leaves, templated visitor:  " << leavesTime << "ms" << endl << endl;
+    cout.unsetf(ios::fixed);
+    cout << setprecision(6);
+}
+
 int main()
 {
     cout << "Number of particles: " << NUM_PARTICLES << endl;
@@ -122,7 +214,10 @@ int main()
         myParticles.push_back(Particle(
             (float)rand()/RAND_MAX, (float)rand()/RAND_MAX, (float)rand()/RAND_MAX));
 
-    cout << endl;
+    cout << endl << "Benchmarking octree builds." << endl << endl;
+    benchmarkBuilds(myParticles, 0.1f);
+    benchmarkBuilds(myParticles, 0.01f);
+
     cout << "Count number of particles within a radius of " << R << "." << endl;
     cout << "Output format: 'p: c' where c is the number of particles" << endl;
     cout << "around particle p." << endl << endl;
@@ -158,11 +253,7 @@ int main()
     Octree<Node> octree(min, max, cellSize);
     
     // Add all particles to the octree.
-    for (int i = 0; i < NUM_PARTICLES; i++)
-    {
-        Node& n = octree.getCell(myParticles[i].pos);
-        n.particles.push_back(&myParticles[i]);
-    }
+    buildOctree(octree, myParticles);
     cout << "Building octree done." << endl << endl;
     
     cout << "Computing result with octree:" << endl;
@@ -174,8 +265,8 @@ int main()
         CallbackTraverse ct;
         ct.count = 0;
         ct.p0 = &myParticles[i];
-        // Invoke the traversal.
-        octree.traverse(&ct);
+        // Invoke the traversal. The callback can also be passed straight to visit, skipping the virtual call.
+        octree.visit(ct);
         cout << ct.count << "  ";
         if (i % 8 == 7)
             cout << endl;
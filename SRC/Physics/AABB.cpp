@@ -1,5 +1,5 @@
 #include "Physics/AABB.h"
-#include <Gizmos.h>
+#include "Physics/DebugDraw.h"
 #include <glm/ext.hpp>
 
 using namespace Physebs;
@@ -18,13 +18,25 @@ AABB::~AABB()
 {
 }
 
-void AABB::Draw()
+void AABB::Draw(DebugDraw* a_debugDraw)
 {
-	// NOTE: Bootstrap treats extents like half-extents when drawing AABBs despite the parameter name so need to halve extents
-	aie::Gizmos::addAABBFilled(m_pos, m_extents / 2.f, m_color);	
+	// NOTE: Debug draw takes half-extents so need to halve extents
+	a_debugDraw->AddAABBFilled(GetPos(), m_extents / 2.f, m_color);	
 
-	aie::Gizmos::addSphere(CalculateMin(), 0.5f, DEFAULT_SPHERE.x, DEFAULT_SPHERE.y, glm::vec4(0, 0, 0, 1));
-	aie::Gizmos::addSphere(CalculateMax(), 0.5f, DEFAULT_SPHERE.x, DEFAULT_SPHERE.y, glm::vec4(1, 1, 1, 1));
+	a_debugDraw->AddSphere(CalculateMin(), 0.5f, DEFAULT_SPHERE.x, DEFAULT_SPHERE.y, glm::vec4(0, 0, 0, 1));
+	a_debugDraw->AddSphere(CalculateMax(), 0.5f, DEFAULT_SPHERE.x, DEFAULT_SPHERE.y, glm::vec4(1, 1, 1, 1));
+}
+
+/**
+*	@brief AABB is its own bounds.
+*	@param a_min is set to the minimum point of the AABB.
+*	@param a_max is set to the maximum point of the AABB.
+*	@return void.
+*/
+void AABB::CalculateBounds(glm::vec3 & a_min, glm::vec3 & a_max) const
+{
+	a_min = CalculateMin();
+	a_max = CalculateMax();
 }
 
 /**
@@ -35,7 +47,7 @@ glm::vec3 AABB::CalculateMin() const
 {
 	glm::vec3 halfExtents = m_extents / 2.f;
 
-	return m_pos - halfExtents;
+	return GetPos() - halfExtents;
 }
 
 /**
@@ -46,7 +58,7 @@ glm::vec3 AABB::CalculateMax() const
 {
 	glm::vec3 halfExtents = m_extents / 2.f;
 
-	return m_pos + halfExtents;
+	return GetPos() + halfExtents;
 }
 
 /**
@@ -56,31 +68,32 @@ glm::vec3 AABB::CalculateMax() const
 std::vector<glm::vec3> AABB::CalculateCorners() const
 {
 	glm::vec3 halfExtents = m_extents / 2.f;
+	glm::vec3 pos = GetPos();
 	std::vector<glm::vec3> corners;
 
 	// Back top left corner
-	corners.push_back(glm::vec3(m_pos.x - halfExtents.x, m_pos.y + halfExtents.y, m_pos.z - halfExtents.z));
+	corners.push_back(glm::vec3(pos.x - halfExtents.x, pos.y + halfExtents.y, pos.z - halfExtents.z));
 
 	// Back top right corner
-	corners.push_back(glm::vec3(m_pos.x + halfExtents.x, m_pos.y + halfExtents.y, m_pos.z - halfExtents.z));
+	corners.push_back(glm::vec3(pos.x + halfExtents.x, pos.y + halfExtents.y, pos.z - halfExtents.z));
 
 	// Forward top left corner
-	corners.push_back(glm::vec3(m_pos.x - halfExtents.x, m_pos.y + halfExtents.y, m_pos.z + halfExtents.z));
+	corners.push_back(glm::vec3(pos.x - halfExtents.x, pos.y + halfExtents.y, pos.z + halfExtents.z));
 
 	// Forward top right corner
-	corners.push_back(glm::vec3(m_pos.x + halfExtents.x, m_pos.y + halfExtents.y, m_pos.z + halfExtents.z));
+	corners.push_back(glm::vec3(pos.x + halfExtents.x, pos.y + halfExtents.y, pos.z + halfExtents.z));
 
 	// Back bottom left corner
-	corners.push_back(glm::vec3(m_pos.x - halfExtents.x, m_pos.y - halfExtents.y, m_pos.z - halfExtents.z));
+	corners.push_back(glm::vec3(pos.x - halfExtents.x, pos.y - halfExtents.y, pos.z - halfExtents.z));
 
 	// Back bottom right corner
-	corners.push_back(glm::vec3(m_pos.x + halfExtents.x, m_pos.y - halfExtents.y, m_pos.z - halfExtents.z));
+	corners.push_back(glm::vec3(pos.x + halfExtents.x, pos.y - halfExtents.y, pos.z - halfExtents.z));
 
 	// Forward bottom left corner
-	corners.push_back(glm::vec3(m_pos.x - halfExtents.x, m_pos.y - halfExtents.y, m_pos.z + halfExtents.z));
+	corners.push_back(glm::vec3(pos.x - halfExtents.x, pos.y - halfExtents.y, pos.z + halfExtents.z));
 
 	// Forward bottom right corner
-	corners.push_back(glm::vec3(m_pos.x + halfExtents.x, m_pos.y - halfExtents.y, m_pos.z + halfExtents.z));
+	corners.push_back(glm::vec3(pos.x + halfExtents.x, pos.y - halfExtents.y, pos.z + halfExtents.z));
 
 	return corners;
 }
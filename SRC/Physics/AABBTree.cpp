@@ -0,0 +1,581 @@
+#include "Physics/AABBTree.h"
+#include "Physics/Rigidbody.h"
+#include "Physics/AABB.h"
+#include "Physics/DebugDraw.h"
+#include "Physics/JobSystem.h"
+#include <assert.h>
+#include <algorithm>
+
+using namespace Physebs;
+
+namespace {
+	/**
+	*	@brief Half the surface area of a box, the cost insertion tries to keep low.
+	*/
+	float HalfArea(const glm::vec3& a_min, const glm::vec3& a_max)
+	{
+		glm::vec3 size = a_max - a_min;
+
+		return size.x * size.y + size.y * size.z + size.z * size.x;
+	}
+
+	glm::vec3 MinOf(const glm::vec3& a_a, const glm::vec3& a_b)
+	{
+		return glm::vec3(std::min(a_a.x, a_b.x), std::min(a_a.y, a_b.y), std::min(a_a.z, a_b.z));
+	}
+
+	glm::vec3 MaxOf(const glm::vec3& a_a, const glm::vec3& a_b)
+	{
+		return glm::vec3(std::max(a_a.x, a_b.x), std::max(a_a.y, a_b.y), std::max(a_a.z, a_b.z));
+	}
+
+	bool Overlaps(const glm::vec3& a_minA, const glm::vec3& a_maxA, const glm::vec3& a_minB, const glm::vec3& a_maxB)
+	{
+		return (a_minA.x <= a_maxB.x && a_maxA.x >= a_minB.x &&
+			a_minA.y <= a_maxB.y && a_maxA.y >= a_minB.y &&
+			a_minA.z <= a_maxB.z && a_maxA.z >= a_minB.z);
+	}
+
+	bool Contains(const glm::vec3& a_outerMin, const glm::vec3& a_outerMax, const glm::vec3& a_innerMin, const glm::vec3& a_innerMax)
+	{
+		return (a_innerMin.x >= a_outerMin.x && a_innerMax.x <= a_outerMax.x &&
+			a_innerMin.y >= a_outerMin.y && a_innerMax.y <= a_outerMax.y &&
+			a_innerMin.z >= a_outerMin.z && a_innerMax.z <= a_outerMax.z);
+	}
+}
+
+AABBTree::AABBTree(float a_margin) : m_margin(a_margin)
+{
+}
+
+/**
+*	@brief Add an object as a new leaf with fattened bounds.
+*	NOTE: Planes are ignored.
+*	@param a_obj is the object to add.
+*	@return void.
+*/
+void AABBTree::Insert(Rigidbody * a_obj)
+{
+	if (a_obj->GetShape() == PLANE) {
+		return;
+	}
+
+	assert(m_entryLookup.find(a_obj) == m_entryLookup.end() && "Attempted to add an object to an AABB tree that already holds it.");
+
+	unsigned int index = (unsigned int)m_entries.size();
+
+	Entry entry;
+	entry.obj = a_obj;
+	a_obj->CalculateBounds(entry.min, entry.max);
+
+	int leaf = AllocateNode();
+	m_nodes[leaf].min	= entry.min - glm::vec3(m_margin);
+	m_nodes[leaf].max	= entry.max + glm::vec3(m_margin);
+	m_nodes[leaf].entry = (int)index;
+
+	entry.leaf = leaf;
+
+	m_entries.push_back(entry);
+	m_entryLookup[a_obj] = index;
+
+	InsertLeaf(leaf);
+}
+
+/**
+*	@brief Take an object's leaf out of the tree, does nothing if the tree doesn't hold it (e.g. planes).
+*	@param a_obj is the object to remove.
+*	@return void.
+*/
+void AABBTree::Remove(Rigidbody * a_obj)
+{
+	auto foundIter = m_entryLookup.find(a_obj);
+
+	if (foundIter == m_entryLookup.end()) {
+		return;
+	}
+
+	unsigned int index	= foundIter->second;
+	unsigned int last	= (unsigned int)m_entries.size() - 1;
+
+	RemoveLeaf(m_entries[index].leaf);
+	FreeNode(m_entries[index].leaf);
+
+	m_entryLookup.erase(foundIter);
+
+	// Swap last entry into the hole and patch its leaf and the lookup
+	if (index != last) {
+		m_entries[index] = m_entries[last];
+
+		m_nodes[m_entries[index].leaf].entry	= (int)index;
+		m_entryLookup[m_entries[index].obj]		= index;
+	}
+
+	m_entries.pop_back();
+}
+
+/**
+*	@brief Remove every object.
+*	@return void.
+*/
+void AABBTree::Clear()
+{
+	m_nodes.clear();
+	m_root		= -1;
+	m_freeList	= -1;
+
+	m_entries.clear();
+	m_entryLookup.clear();
+
+	m_reinsertCount = 0;
+}
+
+/**
+*	@brief Refresh the bounds of every object and re-insert the ones that escaped their fat bounds.
+*	NOTE: Bounds are refreshed in parallel, only escaped objects are touched by the (serial) re-insertion.
+*	@param a_jobSystem is the job system to split the bounds refresh across.
+*	@param a_skipAsleep is whether sleeping objects can be skipped, they haven't moved since the last refit.
+*	@return void.
+*/
+void AABBTree::Refit(JobSystem * a_jobSystem, bool a_skipAsleep)
+{
+	m_movedEntries.clear();
+
+	a_jobSystem->ParallelForCollect(m_entries.size(), PAIR_GRAIN_SIZE, m_threadMoved, m_movedEntries, [this, a_skipAsleep](size_t a_index, std::vector<unsigned int>& a_moved) {
+		Entry& entry = m_entries[a_index];
+
+		if (a_skipAsleep && entry.obj->GetIsAsleep()) {
+			return;
+		}
+
+		entry.obj->CalculateBounds(entry.min, entry.max);
+
+		const Node& leaf = m_nodes[entry.leaf];
+
+		if (!Contains(leaf.min, leaf.max, entry.min, entry.max)) {
+			a_moved.push_back((unsigned int)a_index);
+		}
+	});
+
+	for (auto index : m_movedEntries) {
+		const Entry&	entry	= m_entries[index];
+		int				leaf	= entry.leaf;
+
+		RemoveLeaf(leaf);
+
+		m_nodes[leaf].min = entry.min - glm::vec3(m_margin);
+		m_nodes[leaf].max = entry.max + glm::vec3(m_margin);
+
+		InsertLeaf(leaf);
+	}
+
+	m_reinsertCount = (unsigned int)m_movedEntries.size();
+}
+
+/**
+*	@brief Find every pair of objects with overlapping bounds, each pair is only output once.
+*	NOTE: The tree is descended by fat bounds but pairs are only output if the tight bounds overlap.
+*	@param a_jobSystem is the job system to split the queries across.
+*	@param a_pairs is the list to add found pairs to.
+*	@return void.
+*/
+void AABBTree::FindPairs(JobSystem * a_jobSystem, std::vector<CollisionPair>& a_pairs)
+{
+	if (m_root == -1) {
+		return;
+	}
+
+	// Every moving object queries the tree independently, only keep pairs with a higher entry index or a static or sleeping object (they don't query) so each pair is found once
+	a_jobSystem->ParallelForCollect(m_entries.size(), PAIR_GRAIN_SIZE, m_threadPairs, a_pairs, [this](size_t a_index, std::vector<CollisionPair>& a_found) {
+		if (m_entries[a_index].obj->GetIsActive()) {
+			QueryPairs(m_root, (unsigned int)a_index, a_found);
+		}
+	});
+}
+
+/**
+*	@brief Find every object whose bounds overlap a box.
+*	NOTE: Uses the bounds from the last refit.
+*	@param a_min is the minimum point of the box.
+*	@param a_max is the maximum point of the box.
+*	@param a_results is the list to add overlapping objects to.
+*	@return void.
+*/
+void AABBTree::Query(const glm::vec3 & a_min, const glm::vec3 & a_max, std::vector<Rigidbody*>& a_results) const
+{
+	if (m_root != -1) {
+		QueryNode(m_root, a_min, a_max, a_results);
+	}
+}
+
+/**
+*	@brief Find every object whose fat bounds touch a plane, skipping branches entirely on one side of it.
+*	NOTE: Uses the bounds from the last refit, the fattening means objects near but not touching the plane are found too.
+*	@param a_normal is the direction the plane is facing in.
+*	@param a_dist is how far away from the origin the plane is.
+*	@param a_results is the list to add objects that could be touching the plane to.
+*	@return TRUE as the tree can always cull.
+*/
+bool AABBTree::QueryPlane(const glm::vec3 & a_normal, float a_dist, std::vector<Rigidbody*>& a_results) const
+{
+	if (m_root != -1) {
+		QueryPlaneNode(m_root, a_normal, a_dist, a_results);
+	}
+
+	return true;
+}
+
+/**
+*	@brief Draw the fat bounds of every node.
+*	@param a_debugDraw is the debug draw sink to send the nodes to.
+*	@param a_color is the color to draw the nodes in.
+*	@return void.
+*/
+void AABBTree::Draw(DebugDraw * a_debugDraw, const glm::vec4 & a_color) const
+{
+	for (auto& node : m_nodes) {
+
+		if (node.height >= 0) {
+			a_debugDraw->AddAABB((node.min + node.max) / 2.f, (node.max - node.min) / 2.f, a_color);
+		}
+	}
+}
+
+/**
+*	@brief Get an unused node, reusing freed ones before growing the node list.
+*	@return Index of the node.
+*/
+int AABBTree::AllocateNode()
+{
+	int node;
+
+	if (m_freeList != -1) {
+		node		= m_freeList;
+		m_freeList	= m_nodes[node].parent;
+	}
+	else {
+		node = (int)m_nodes.size();
+		m_nodes.push_back(Node());
+	}
+
+	m_nodes[node].parent	= -1;
+	m_nodes[node].child1	= -1;
+	m_nodes[node].child2	= -1;
+	m_nodes[node].height	= 0;
+	m_nodes[node].entry		= -1;
+
+	return node;
+}
+
+void AABBTree::FreeNode(int a_node)
+{
+	m_nodes[a_node].parent	= m_freeList;
+	m_nodes[a_node].height	= -1;
+	m_freeList				= a_node;
+}
+
+/**
+*	@brief Find the cheapest sibling for a leaf, pair it with the sibling under a new parent and rebalance up to the root.
+*	@param a_leaf is the leaf to insert (its fat bounds must already be set).
+*	@return void.
+*/
+void AABBTree::InsertLeaf(int a_leaf)
+{
+	if (m_root == -1) {
+		m_root = a_leaf;
+		m_nodes[a_leaf].parent = -1;
+
+		return;
+	}
+
+	glm::vec3 leafMin = m_nodes[a_leaf].min;
+	glm::vec3 leafMax = m_nodes[a_leaf].max;
+
+	/// 1. Descend towards the sibling that adds the least surface area to the tree
+	int index = m_root;
+
+	while (!m_nodes[index].IsLeaf()) {
+		const Node& node = m_nodes[index];
+
+		float area			= HalfArea(node.min, node.max);
+		float combinedArea	= HalfArea(MinOf(node.min, leafMin), MaxOf(node.max, leafMax));
+
+		// Cost of making the leaf a sibling of this node, and the cost every node below here pays for growing to fit the leaf
+		float cost				= 2.f * combinedArea;
+		float inheritanceCost	= 2.f * (combinedArea - area);
+
+		float childCosts[2];
+		int children[2] = { node.child1, node.child2 };
+
+		for (int i = 0; i < 2; ++i) {
+			const Node& child = m_nodes[children[i]];
+
+			float grownArea = HalfArea(MinOf(child.min, leafMin), MaxOf(child.max, leafMax));
+
+			childCosts[i] = child.IsLeaf() ? grownArea + inheritanceCost : (grownArea - HalfArea(child.min, child.max)) + inheritanceCost;
+		}
+
+		if (cost < childCosts[0] && cost < childCosts[1]) {
+			break;
+		}
+
+		index = (childCosts[0] < childCosts[1]) ? children[0] : children[1];
+	}
+
+	/// 2. Create a new parent for the sibling and the leaf
+	int sibling		= index;
+	int oldParent	= m_nodes[sibling].parent;
+	int newParent	= AllocateNode();
+
+	m_nodes[newParent].parent	= oldParent;
+	m_nodes[newParent].min		= MinOf(leafMin, m_nodes[sibling].min);
+	m_nodes[newParent].max		= MaxOf(leafMax, m_nodes[sibling].max);
+	m_nodes[newParent].height	= m_nodes[sibling].height + 1;
+	m_nodes[newParent].child1	= sibling;
+	m_nodes[newParent].child2	= a_leaf;
+
+	if (oldParent != -1) {
+		if (m_nodes[oldParent].child1 == sibling) {
+			m_nodes[oldParent].child1 = newParent;
+		}
+		else {
+			m_nodes[oldParent].child2 = newParent;
+		}
+	}
+	else {
+		m_root = newParent;
+	}
+
+	m_nodes[sibling].parent = newParent;
+	m_nodes[a_leaf].parent	= newParent;
+
+	/// 3. Walk back up refitting bounds and heights
+	FixUpwards(newParent);
+}
+
+/**
+*	@brief Take a leaf out of the tree, its sibling takes the place of their parent.
+*	NOTE: The leaf node itself is not freed.
+*	@param a_leaf is the leaf to remove.
+*	@return void.
+*/
+void AABBTree::RemoveLeaf(int a_leaf)
+{
+	if (a_leaf == m_root) {
+		m_root = -1;
+
+		return;
+	}
+
+	int parent		= m_nodes[a_leaf].parent;
+	int grandParent = m_nodes[parent].parent;
+	int sibling		= (m_nodes[parent].child1 == a_leaf) ? m_nodes[parent].child2 : m_nodes[parent].child1;
+
+	if (grandParent != -1) {
+		if (m_nodes[grandParent].child1 == parent) {
+			m_nodes[grandParent].child1 = sibling;
+		}
+		else {
+			m_nodes[grandParent].child2 = sibling;
+		}
+
+		m_nodes[sibling].parent = grandParent;
+		FreeNode(parent);
+
+		FixUpwards(grandParent);
+	}
+	else {
+		m_root = sibling;
+		m_nodes[sibling].parent = -1;
+		FreeNode(parent);
+	}
+}
+
+/**
+*	@brief Rebalance, refit bounds and heights from a node up to the root.
+*	@param a_node is the first node to fix.
+*	@return void.
+*/
+void AABBTree::FixUpwards(int a_node)
+{
+	int index = a_node;
+
+	while (index != -1) {
+		index = Balance(index);
+
+		Node& node = m_nodes[index];
+		const Node& child1 = m_nodes[node.child1];
+		const Node& child2 = m_nodes[node.child2];
+
+		node.height = 1 + std::max(child1.height, child2.height);
+		node.min	= MinOf(child1.min, child2.min);
+		node.max	= MaxOf(child1.max, child2.max);
+
+		index = node.parent;
+	}
+}
+
+/**
+*	@brief If one child of a node is more than one level taller than the other, rotate the taller child up into the node's place.
+*	@param a_node is the node to balance (A), with children B and C.
+*	@return Index of the node now in A's place.
+*/
+int AABBTree::Balance(int a_node)
+{
+	int iA = a_node;
+
+	if (m_nodes[iA].IsLeaf() || m_nodes[iA].height < 2) {
+		return iA;
+	}
+
+	int iB = m_nodes[iA].child1;
+	int iC = m_nodes[iA].child2;
+
+	int balance = m_nodes[iC].height - m_nodes[iB].height;
+
+	if (balance >= -1 && balance <= 1) {
+		return iA;
+	}
+
+	// Taller child is promoted (P), the shorter child stays under A (S)
+	bool	b_promoteC	= balance > 1;
+	int		iP			= b_promoteC ? iC : iB;
+	int		iS			= b_promoteC ? iB : iC;
+
+	Node& A = m_nodes[iA];
+	Node& P = m_nodes[iP];
+
+	int iF = P.child1;
+	int iG = P.child2;
+
+	/// 1. P takes A's place and A becomes P's child
+	P.child1 = iA;
+	P.parent = A.parent;
+	A.parent = iP;
+
+	if (P.parent != -1) {
+		if (m_nodes[P.parent].child1 == iA) {
+			m_nodes[P.parent].child1 = iP;
+		}
+		else {
+			m_nodes[P.parent].child2 = iP;
+		}
+	}
+	else {
+		m_root = iP;
+	}
+
+	/// 2. P keeps its taller child, the shorter one moves under A in P's old place
+	int iKeep	= (m_nodes[iF].height > m_nodes[iG].height) ? iF : iG;
+	int iMove	= (iKeep == iF) ? iG : iF;
+
+	P.child2 = iKeep;
+
+	if (b_promoteC) {
+		A.child2 = iMove;
+	}
+	else {
+		A.child1 = iMove;
+	}
+
+	m_nodes[iMove].parent = iA;
+
+	const Node& S		= m_nodes[iS];
+	const Node& moved	= m_nodes[iMove];
+	const Node& kept	= m_nodes[iKeep];
+
+	A.min		= MinOf(S.min, moved.min);
+	A.max		= MaxOf(S.max, moved.max);
+	A.height	= 1 + std::max(S.height, moved.height);
+
+	P.min		= MinOf(A.min, kept.min);
+	P.max		= MaxOf(A.max, kept.max);
+	P.height	= 1 + std::max(A.height, kept.height);
+
+	return iP;
+}
+
+/**
+*	@brief Recursively check an entry against the leaves under a node, skipping subtrees whose bounds don't overlap it.
+*	@param a_node is the node to check.
+*	@param a_entry is the index of the entry to check.
+*	@param a_pairs is the list to add found pairs to.
+*	@return void.
+*/
+void AABBTree::QueryPairs(int a_node, unsigned int a_entry, std::vector<CollisionPair>& a_pairs) const
+{
+	const Node&		node	= m_nodes[a_node];
+	const Entry&	entry	= m_entries[a_entry];
+
+	if (!Overlaps(node.min, node.max, entry.min, entry.max)) {
+		return;
+	}
+
+	if (node.IsLeaf()) {
+		const Entry& other = m_entries[node.entry];
+
+		if (((unsigned int)node.entry > a_entry || !other.obj->GetIsActive()) && Overlaps(entry.min, entry.max, other.min, other.max)) {
+			a_pairs.push_back(CollisionPair{ entry.obj, other.obj });
+		}
+
+		return;
+	}
+
+	QueryPairs(node.child1, a_entry, a_pairs);
+	QueryPairs(node.child2, a_entry, a_pairs);
+}
+
+/**
+*	@brief Recursively gather the objects under a node whose bounds overlap a box.
+*	@param a_node is the node to check.
+*	@param a_min is the minimum point of the box.
+*	@param a_max is the maximum point of the box.
+*	@param a_results is the list to add overlapping objects to.
+*	@return void.
+*/
+void AABBTree::QueryNode(int a_node, const glm::vec3 & a_min, const glm::vec3 & a_max, std::vector<Rigidbody*>& a_results) const
+{
+	const Node& node = m_nodes[a_node];
+
+	if (!Overlaps(node.min, node.max, a_min, a_max)) {
+		return;
+	}
+
+	if (node.IsLeaf()) {
+		const Entry& entry = m_entries[node.entry];
+
+		if (Overlaps(entry.min, entry.max, a_min, a_max)) {
+			a_results.push_back(entry.obj);
+		}
+
+		return;
+	}
+
+	QueryNode(node.child1, a_min, a_max, a_results);
+	QueryNode(node.child2, a_min, a_max, a_results);
+}
+
+/**
+*	@brief Recursively gather the objects under a node whose fat bounds touch a plane.
+*	@param a_node is the node to check.
+*	@param a_normal is the direction the plane is facing in.
+*	@param a_dist is how far away from the origin the plane is.
+*	@param a_results is the list to add objects that could be touching the plane to.
+*	@return void.
+*/
+void AABBTree::QueryPlaneNode(int a_node, const glm::vec3 & a_normal, float a_dist, std::vector<Rigidbody*>& a_results) const
+{
+	const Node& node = m_nodes[a_node];
+
+	if (!AABB::MinMaxTouchesPlane(node.min, node.max, a_normal, a_dist)) {
+		return;
+	}
+
+	if (node.IsLeaf()) {
+		a_results.push_back(m_entries[node.entry].obj);
+
+		return;
+	}
+
+	QueryPlaneNode(node.child1, a_normal, a_dist, a_results);
+	QueryPlaneNode(node.child2, a_normal, a_dist, a_results);
+}
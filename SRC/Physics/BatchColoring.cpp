@@ -0,0 +1,91 @@
+#include "Physics/BatchColoring.h"
+#include <assert.h>
+
+using namespace Physebs;
+
+const unsigned int BatchColoring::NO_BODY;
+const unsigned int BatchColoring::MAX_BATCHES;
+
+/**
+*	@brief Forget the last coloring and start over with every body in no batches.
+*	@param a_bodyCount is how many bodies the items can refer to.
+*	@return void.
+*/
+void BatchColoring::Begin(size_t a_bodyCount)
+{
+	m_bodyBatches.assign(a_bodyCount, 0);
+	m_itemBatches.clear();
+	m_batchItems.clear();
+	m_batchStarts.clear();
+}
+
+/**
+*	@brief Color the next item, putting it in the first batch neither of its bodies is in yet.
+*	NOTE: Falls back on the serial batch once every batch holds one of its bodies.
+*	@param a_first is the first body the item writes to, NO_BODY if it doesn't write to one.
+*	@param a_second is the second body the item writes to, NO_BODY if it doesn't write to one.
+*	@return void.
+*/
+void BatchColoring::Add(unsigned int a_first, unsigned int a_second)
+{
+	assert((a_first == NO_BODY || a_first < m_bodyBatches.size()) && (a_second == NO_BODY || a_second < m_bodyBatches.size()) && "Attempted to color an item with a body that wasn't counted in Begin.");
+
+	uint64_t used = 0;
+
+	if (a_first != NO_BODY) {
+		used |= m_bodyBatches[a_first];
+	}
+	if (a_second != NO_BODY) {
+		used |= m_bodyBatches[a_second];
+	}
+
+	unsigned int batch = 0;
+
+	while (batch < MAX_BATCHES && (used >> batch & 1)) {
+		batch++;
+	}
+
+	if (batch < MAX_BATCHES) {
+		if (a_first != NO_BODY) {
+			m_bodyBatches[a_first] |= (uint64_t)1 << batch;
+		}
+		if (a_second != NO_BODY) {
+			m_bodyBatches[a_second] |= (uint64_t)1 << batch;
+		}
+	}
+
+	m_itemBatches.push_back((unsigned char)batch);
+}
+
+/**
+*	@brief Group the items added into their batches with a counting sort, keeping the order they were added in within each batch.
+*	NOTE: Only the batches up to the last used one are kept, the serial batch is only there if an item needed it.
+*	@return void.
+*/
+void BatchColoring::End()
+{
+	size_t counts[MAX_BATCHES + 1] = {};
+	size_t batchCount = 0;
+
+	for (unsigned char batch : m_itemBatches) {
+		counts[batch]++;
+
+		if (batch + 1u > batchCount) {
+			batchCount = batch + 1u;
+		}
+	}
+
+	m_batchStarts.resize(batchCount + 1);
+	m_batchStarts[0] = 0;
+
+	for (size_t i = 0; i < batchCount; ++i) {
+		m_batchStarts[i + 1] = m_batchStarts[i] + counts[i];
+		counts[i] = m_batchStarts[i];
+	}
+
+	m_batchItems.resize(m_itemBatches.size());
+
+	for (size_t i = 0; i < m_itemBatches.size(); ++i) {
+		m_batchItems[counts[m_itemBatches[i]]++] = (unsigned int)i;
+	}
+}
@@ -0,0 +1,225 @@
+#include "Physics/BodyStore.h"
+#include "Physics/Rigidbody.h"
+#include <assert.h>
+
+using namespace Physebs;
+
+const unsigned int BodyStore::NO_ISLAND;
+
+/**
+*	@brief Move a Rigidbody's physics state into a new slot at the end of the store and make the body a view over it.
+*	@param a_obj is the body to take in.
+*	@return Store index of the new slot.
+*/
+unsigned int BodyStore::Add(Rigidbody * a_obj)
+{
+	assert(a_obj->m_store == nullptr && "Attempted to add a Rigidbody that is already owned by a body store.");
+
+	unsigned int index = (unsigned int)owners.size();
+
+	pos.push_back(a_obj->m_pos);
+	vel.push_back(a_obj->m_vel);
+	accel.push_back(a_obj->m_accel);
+
+	mass.push_back(a_obj->m_mass);
+	invMass.push_back(1.f / a_obj->m_mass);
+	frict.push_back(a_obj->m_frict);
+	restitution.push_back(a_obj->m_restitution);
+
+	dynamic.push_back(Flag{ a_obj->b_dynamic });
+	asleep.push_back(Flag{ false });
+	restTime.push_back(0.f);
+	island.push_back(NO_ISLAND);
+
+	owners.push_back(a_obj);
+
+	// Body now reads and writes through the store
+	a_obj->m_store		= this;
+	a_obj->m_storeIndex = index;
+
+	return index;
+}
+
+/**
+*	@brief Copy a Rigidbody's physics state back into the body and free its slot by moving the last slot into it.
+*	@param a_obj is the body to give back its state.
+*	@return void.
+*/
+void BodyStore::Remove(Rigidbody * a_obj)
+{
+	assert(a_obj->m_store == this && "Attempted to remove a Rigidbody from a body store that does not own it.");
+
+	// Bodies resting on this one could be left floating, let them fall
+	if (island[a_obj->m_storeIndex] != NO_ISLAND) {
+		WakeIsland(island[a_obj->m_storeIndex]);
+	}
+
+	unsigned int index	= a_obj->m_storeIndex;
+	unsigned int last	= (unsigned int)owners.size() - 1;
+
+	// Body keeps its last known state so it is still valid outside of the scene
+	a_obj->m_pos			= pos[index];
+	a_obj->m_vel			= vel[index];
+	a_obj->m_accel			= accel[index];
+	a_obj->m_mass			= mass[index];
+	a_obj->m_frict			= frict[index];
+	a_obj->m_restitution	= restitution[index];
+	a_obj->b_dynamic		= dynamic[index].value;
+
+	a_obj->m_store		= nullptr;
+	a_obj->m_storeIndex = 0;
+
+	// Swap last slot into the hole so arrays stay contiguous, then patch the moved body's view
+	if (index != last) {
+		pos[index]			= pos[last];
+		vel[index]			= vel[last];
+		accel[index]		= accel[last];
+		mass[index]			= mass[last];
+		invMass[index]		= invMass[last];
+		frict[index]		= frict[last];
+		restitution[index]	= restitution[last];
+		dynamic[index]		= dynamic[last];
+		asleep[index]		= asleep[last];
+		restTime[index]		= restTime[last];
+		island[index]		= island[last];
+		owners[index]		= owners[last];
+
+		owners[index]->m_storeIndex = index;
+	}
+
+	pos.pop_back();
+	vel.pop_back();
+	accel.pop_back();
+	mass.pop_back();
+	invMass.pop_back();
+	frict.pop_back();
+	restitution.pop_back();
+	dynamic.pop_back();
+	asleep.pop_back();
+	restTime.pop_back();
+	island.pop_back();
+	owners.pop_back();
+}
+
+/**
+*	@brief Drop every slot without copying state back.
+*	NOTE: Only use when the owning bodies are about to be deleted.
+*	@return void.
+*/
+void BodyStore::Clear()
+{
+	pos.clear();
+	vel.clear();
+	accel.clear();
+	mass.clear();
+	invMass.clear();
+	frict.clear();
+	restitution.clear();
+	dynamic.clear();
+	asleep.clear();
+	restTime.clear();
+	island.clear();
+	owners.clear();
+
+	islands.clear();
+	freeIslands.clear();
+}
+
+/**
+*	@brief Reserve capacity in every array so adding many bodies doesn't reallocate.
+*	@param a_count is the total number of bodies to make room for.
+*	@return void.
+*/
+void BodyStore::Reserve(size_t a_count)
+{
+	pos.reserve(a_count);
+	vel.reserve(a_count);
+	accel.reserve(a_count);
+	mass.reserve(a_count);
+	invMass.reserve(a_count);
+	frict.reserve(a_count);
+	restitution.reserve(a_count);
+	dynamic.reserve(a_count);
+	asleep.reserve(a_count);
+	restTime.reserve(a_count);
+	island.reserve(a_count);
+	owners.reserve(a_count);
+}
+
+/**
+*	@brief Put a group of bodies to sleep as one island, they stop moving until something wakes the island.
+*	NOTE: Any sleeping island one of the bodies is part of is taken apart, its bodies should be in the group too.
+*	@param a_indices are the store indices of the bodies.
+*	@param a_count is how many bodies there are.
+*	@return void.
+*/
+void BodyStore::SleepIsland(const unsigned int * a_indices, size_t a_count)
+{
+	// Free the islands being merged in, their bodies are all re-added below
+	for (size_t i = 0; i < a_count; ++i) {
+		unsigned int oldIsland = island[a_indices[i]];
+
+		if (oldIsland != NO_ISLAND && !islands[oldIsland].empty()) {
+			islands[oldIsland].clear();
+			freeIslands.push_back(oldIsland);
+		}
+	}
+
+	unsigned int newIsland;
+
+	if (!freeIslands.empty()) {
+		newIsland = freeIslands.back();
+		freeIslands.pop_back();
+	}
+	else {
+		newIsland = (unsigned int)islands.size();
+		islands.emplace_back();
+	}
+
+	std::vector<Rigidbody*>& members = islands[newIsland];
+
+	for (size_t i = 0; i < a_count; ++i) {
+		unsigned int index = a_indices[i];
+
+		asleep[index].value = true;
+		island[index]		= newIsland;
+		vel[index]			= glm::vec3();
+		accel[index]		= glm::vec3();
+
+		members.push_back(owners[index]);
+	}
+}
+
+/**
+*	@brief Wake every body in a sleeping island, they have to rest for a while again before going back to sleep.
+*	@param a_island is the island to wake.
+*	@return void.
+*/
+void BodyStore::WakeIsland(unsigned int a_island)
+{
+	assert(a_island < islands.size() && !islands[a_island].empty() && "Attempted to wake an island that is not asleep.");
+
+	for (auto obj : islands[a_island]) {
+		unsigned int index = obj->m_storeIndex;
+
+		asleep[index].value = false;
+		restTime[index]		= 0.f;
+		island[index]		= NO_ISLAND;
+	}
+
+	islands[a_island].clear();
+	freeIslands.push_back(a_island);
+}
+
+/**
+*	@brief Wake every sleeping island (e.g. when sleeping is turned off).
+*	@return void.
+*/
+void BodyStore::WakeAll()
+{
+	for (unsigned int i = 0; i < islands.size(); ++i) {
+		if (!islands[i].empty()) {
+			WakeIsland(i);
+		}
+	}
+}
@@ -0,0 +1,109 @@
+#include "Physics/BruteForce.h"
+#include "Physics/Rigidbody.h"
+#include "Physics/JobSystem.h"
+#include <assert.h>
+
+using namespace Physebs;
+
+/**
+*	@brief Add an object.
+*	NOTE: Planes are ignored.
+*	@param a_obj is the object to add.
+*	@return void.
+*/
+void BruteForce::Insert(Rigidbody * a_obj)
+{
+	if (a_obj->GetShape() == PLANE) {
+		return;
+	}
+
+	assert(m_entryLookup.find(a_obj) == m_entryLookup.end() && "Attempted to add an object to a brute force broadphase that already holds it.");
+
+	Entry entry;
+	entry.obj = a_obj;
+	a_obj->CalculateBounds(entry.min, entry.max);
+
+	m_entryLookup[a_obj] = (unsigned int)m_entries.size();
+	m_entries.push_back(entry);
+}
+
+/**
+*	@brief Take an object out, does nothing if the broadphase doesn't hold it (e.g. planes).
+*	@param a_obj is the object to remove.
+*	@return void.
+*/
+void BruteForce::Remove(Rigidbody * a_obj)
+{
+	auto foundIter = m_entryLookup.find(a_obj);
+
+	if (foundIter == m_entryLookup.end()) {
+		return;
+	}
+
+	unsigned int index	= foundIter->second;
+	unsigned int last	= (unsigned int)m_entries.size() - 1;
+
+	m_entryLookup.erase(foundIter);
+
+	if (index != last) {
+		m_entries[index]					= m_entries[last];
+		m_entryLookup[m_entries[index].obj] = index;
+	}
+
+	m_entries.pop_back();
+}
+
+/**
+*	@brief Remove every object.
+*	@return void.
+*/
+void BruteForce::Clear()
+{
+	m_entries.clear();
+	m_entryLookup.clear();
+}
+
+/**
+*	@brief Refresh the bounds of every object.
+*	@param a_jobSystem is the job system to split the bounds refresh across.
+*	@param a_skipAsleep is whether sleeping objects can be skipped, they haven't moved since the last refit.
+*	@return void.
+*/
+void BruteForce::Refit(JobSystem * a_jobSystem, bool a_skipAsleep)
+{
+	a_jobSystem->ParallelFor(m_entries.size(), JOB_GRAIN_SIZE, [this, a_skipAsleep](size_t a_begin, size_t a_end, unsigned int) {
+		for (size_t i = a_begin; i < a_end; ++i) {
+			if (a_skipAsleep && m_entries[i].obj->GetIsAsleep()) {
+				continue;
+			}
+
+			m_entries[i].obj->CalculateBounds(m_entries[i].min, m_entries[i].max);
+		}
+	});
+}
+
+/**
+*	@brief Check the bounds of every object against every object after it, each pair is only output once.
+*	NOTE: Uses the bounds from the last refit.
+*	@param a_jobSystem is the job system to split the checks across.
+*	@param a_pairs is the list to add found pairs to.
+*	@return void.
+*/
+void BruteForce::FindPairs(JobSystem * a_jobSystem, std::vector<CollisionPair>& a_pairs)
+{
+	// Each object checks every object after it so the work per object varies a lot, use small chunks to keep threads busy
+	a_jobSystem->ParallelForCollect(m_entries.size(), PAIR_GRAIN_SIZE / 8, m_threadPairs, a_pairs, [this](size_t a_index, std::vector<CollisionPair>& a_found) {
+		const Entry& entry = m_entries[a_index];
+
+		for (size_t i = a_index + 1; i < m_entries.size(); ++i) {
+			const Entry& other = m_entries[i];
+
+			if (entry.min.x <= other.max.x && entry.max.x >= other.min.x &&
+				entry.min.y <= other.max.y && entry.max.y >= other.min.y &&
+				entry.min.z <= other.max.z && entry.max.z >= other.min.z)
+			{
+				a_found.push_back(CollisionPair{ entry.obj, other.obj });
+			}
+		}
+	});
+}
@@ -0,0 +1,161 @@
+#include "Physics/JobSystem.h"
+#include <assert.h>
+
+using namespace Physebs;
+
+JobSystem::JobSystem(unsigned int a_threadCount) : m_pendingTasks(0)
+{
+	// Use every hardware thread if no count was given (hardware_concurrency can return 0 if it can't be determined)
+	if (a_threadCount == 0) {
+		a_threadCount = std::thread::hardware_concurrency();
+	}
+
+	m_threadCount = (a_threadCount > 0) ? a_threadCount : 1;
+	m_queues.reset(new WorkQueue[m_threadCount]);
+
+	// Calling thread is thread 0, only spawn the rest
+	for (unsigned int i = 1; i < m_threadCount; ++i) {
+		m_workers.push_back(std::thread(&JobSystem::WorkerLoop, this, i));
+	}
+}
+
+JobSystem::~JobSystem()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_wakeMutex);
+		b_quit = true;
+	}
+	m_wakeCondition.notify_all();
+
+	for (auto& worker : m_workers) {
+		worker.join();
+	}
+}
+
+/**
+*	@brief Split [0, a_count) into chunks of a_grainSize and run the job over every chunk across all threads, returning once all chunks are done.
+*	NOTE: Must be called from the thread that owns the job system, not from inside a job.
+*	@param a_count is the number of items in the range.
+*	@param a_grainSize is the number of items per chunk, small enough to balance but large enough to outweigh queueing.
+*	@param a_job is the function to run over each chunk.
+*	@return void.
+*/
+void JobSystem::ParallelFor(size_t a_count, size_t a_grainSize, const Job & a_job)
+{
+	if (a_count == 0) {
+		return;
+	}
+
+	if (a_grainSize == 0) {
+		a_grainSize = 1;
+	}
+
+	// Not worth distributing, run on calling thread
+	if (m_threadCount == 1 || a_count <= a_grainSize) {
+		a_job(0, a_count, 0);
+		return;
+	}
+
+	size_t				chunkCount = (a_count + a_grainSize - 1) / a_grainSize;
+	std::atomic<size_t> remaining(chunkCount);
+
+	/// 1. Deal chunks round-robin into every thread's queue so each starts with local work
+	for (size_t chunk = 0; chunk < chunkCount; ++chunk) {
+		size_t begin	= chunk * a_grainSize;
+		size_t end		= (begin + a_grainSize < a_count) ? begin + a_grainSize : a_count;
+
+		WorkQueue& queue = m_queues[chunk % m_threadCount];
+
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		queue.tasks.push_back(Task{ &a_job, begin, end, &remaining });
+	}
+
+	/// 2. Wake workers (lock so a worker can't miss the wake between checking for tasks and going to sleep)
+	{
+		std::lock_guard<std::mutex> lock(m_wakeMutex);
+		m_pendingTasks += chunkCount;
+	}
+	m_wakeCondition.notify_all();
+
+	/// 3. Help out until every chunk of this parallel-for is finished
+	while (remaining.load() > 0) {
+		Task task;
+
+		if (TryGetTask(0, task)) {
+			RunTask(task, 0);
+		}
+		else {
+			std::this_thread::yield();
+		}
+	}
+}
+
+/**
+*	@brief Run tasks until the job system is destroyed, sleeping while there is nothing to do.
+*	@param a_threadIndex is the index of the worker's queue.
+*	@return void.
+*/
+void JobSystem::WorkerLoop(unsigned int a_threadIndex)
+{
+	while (true) {
+		Task task;
+
+		if (TryGetTask(a_threadIndex, task)) {
+			RunTask(task, a_threadIndex);
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock(m_wakeMutex);
+		m_wakeCondition.wait(lock, [this]() { return b_quit || m_pendingTasks.load() > 0; });
+
+		if (b_quit) {
+			return;
+		}
+	}
+}
+
+/**
+*	@brief Take a task from the back of the thread's own queue, or steal one from the front of another thread's queue.
+*	@param a_threadIndex is the index of the thread looking for work.
+*	@param a_task is the task to fill in if one was found.
+*	@return TRUE: Task was found | FALSE: Every queue is empty
+*/
+bool JobSystem::TryGetTask(unsigned int a_threadIndex, Task & a_task)
+{
+	for (unsigned int i = 0; i < m_threadCount; ++i) {
+		unsigned int	queueIndex	= (a_threadIndex + i) % m_threadCount;
+		WorkQueue&		queue		= m_queues[queueIndex];
+
+		std::lock_guard<std::mutex> lock(queue.mutex);
+
+		if (queue.tasks.empty()) {
+			continue;
+		}
+
+		// Own queue is LIFO (most recently queued is most likely still in cache), stolen work is FIFO
+		if (i == 0) {
+			a_task = queue.tasks.back();
+			queue.tasks.pop_back();
+		}
+		else {
+			a_task = queue.tasks.front();
+			queue.tasks.pop_front();
+		}
+
+		--m_pendingTasks;
+
+		return true;
+	}
+
+	return false;
+}
+
+void JobSystem::RunTask(const Task & a_task, unsigned int a_threadIndex)
+{
+	assert(a_task.job && "Job system task has no job to run.");
+
+	(*a_task.job)(a_task.begin, a_task.end, a_threadIndex);
+
+	// Let the parallel-for know this chunk is done (must be last, the counter lives on the caller's stack)
+	--(*a_task.remaining);
+}
@@ -0,0 +1,437 @@
+#include "Physics/LooseOctree.h"
+#include "Physics/Rigidbody.h"
+#include "Physics/AABB.h"
+#include "Physics/DebugDraw.h"
+#include "Physics/JobSystem.h"
+#include <assert.h>
+#include <algorithm>
+
+using namespace Physebs;
+
+LooseOctree::LooseOctree(const glm::vec3 & a_origin, const glm::vec3 & a_halfExtents, float a_looseness, unsigned int a_splitThreshold, unsigned int a_maxDepth)
+	:
+	m_looseness(a_looseness), m_splitThreshold(a_splitThreshold), m_maxDepth(a_maxDepth)
+{
+	assert(a_looseness >= 1.f && "Loose octree looseness must be at least 1 or cells won't cover their own volume.");
+
+	// Cells are cubic, root has to cover the largest simulation extent
+	Cell root;
+	root.center		= a_origin;
+	root.halfSize	= std::max(std::max(a_halfExtents.x, a_halfExtents.y), a_halfExtents.z);
+	root.parent		= -1;
+	root.firstChild = -1;
+	root.depth		= 0;
+	root.subtreeCount = 0;
+
+	m_cells.push_back(root);
+}
+
+/**
+*	@brief Add an object to the deepest cell that can hold it.
+*	NOTE: Planes are ignored.
+*	@param a_obj is the object to add.
+*	@return void.
+*/
+void LooseOctree::Insert(Rigidbody * a_obj)
+{
+	if (a_obj->GetShape() == PLANE) {
+		return;
+	}
+
+	assert(m_entryLookup.find(a_obj) == m_entryLookup.end() && "Attempted to add an object to a loose octree that already holds it.");
+
+	unsigned int index = (unsigned int)m_entries.size();
+
+	Entry entry;
+	entry.obj	= a_obj;
+	entry.cell	= -1;
+	entry.slot	= 0;
+	a_obj->CalculateBounds(entry.min, entry.max);
+
+	m_entries.push_back(entry);
+	m_entryLookup[a_obj] = index;
+
+	InsertEntry(index, 0);
+}
+
+/**
+*	@brief Take an object out of the tree, does nothing if the tree doesn't hold it (e.g. planes).
+*	@param a_obj is the object to remove.
+*	@return void.
+*/
+void LooseOctree::Remove(Rigidbody * a_obj)
+{
+	auto foundIter = m_entryLookup.find(a_obj);
+
+	if (foundIter == m_entryLookup.end()) {
+		return;
+	}
+
+	unsigned int index	= foundIter->second;
+	unsigned int last	= (unsigned int)m_entries.size() - 1;
+
+	DetachEntry(index);
+	m_entryLookup.erase(foundIter);
+
+	// Swap last entry into the hole and patch where its cell and the lookup point to
+	if (index != last) {
+		m_entries[index] = m_entries[last];
+
+		Entry& moved = m_entries[index];
+		m_cells[moved.cell].entries[moved.slot]	= index;
+		m_entryLookup[moved.obj]				= index;
+	}
+
+	m_entries.pop_back();
+}
+
+/**
+*	@brief Remove every object and collapse the tree back down to the root.
+*	@return void.
+*/
+void LooseOctree::Clear()
+{
+	m_cells.resize(1);
+	m_cells[0].firstChild	= -1;
+	m_cells[0].subtreeCount = 0;
+	m_cells[0].entries.clear();
+
+	m_entries.clear();
+	m_entryLookup.clear();
+
+	m_reinsertCount = 0;
+}
+
+/**
+*	@brief Refresh the bounds of every object and move the ones that left the loose bounds of their cell.
+*	NOTE: Bounds are refreshed in parallel, only objects that changed cell are touched by the (serial) re-insertion.
+*	@param a_jobSystem is the job system to split the bounds refresh across.
+*	@param a_skipAsleep is whether sleeping objects can be skipped, they haven't moved since the last refit.
+*	@return void.
+*/
+void LooseOctree::Refit(JobSystem * a_jobSystem, bool a_skipAsleep)
+{
+	// Find which objects need to move
+	m_movedEntries.clear();
+
+	a_jobSystem->ParallelForCollect(m_entries.size(), PAIR_GRAIN_SIZE, m_threadMoved, m_movedEntries, [this, a_skipAsleep](size_t a_index, std::vector<unsigned int>& a_moved) {
+		Entry& entry = m_entries[a_index];
+
+		if (a_skipAsleep && entry.obj->GetIsAsleep()) {
+			return;
+		}
+
+		entry.obj->CalculateBounds(entry.min, entry.max);
+
+		if (!LooseContains(entry.cell, entry.min, entry.max)) {
+			// Nowhere further up to go
+			if (entry.cell != 0) {
+				a_moved.push_back((unsigned int)a_index);
+			}
+		}
+		// Objects kept in the root while outside of the tree have come back and can go deeper
+		else if (entry.cell == 0 && m_cells[0].firstChild != -1) {
+			int child = ChildContaining(0, (entry.min + entry.max) / 2.f);
+
+			if (LooseContains(child, entry.min, entry.max)) {
+				a_moved.push_back((unsigned int)a_index);
+			}
+		}
+	});
+
+	// Re-insert from the closest ancestor that still contains the object, usually only a level or two up
+	for (auto index : m_movedEntries) {
+		Entry&	entry	= m_entries[index];
+		int		cell	= entry.cell;
+
+		DetachEntry(index);
+
+		while (cell != 0 && !LooseContains(cell, entry.min, entry.max)) {
+			cell = m_cells[cell].parent;
+		}
+
+		InsertEntry(index, cell);
+	}
+
+	m_reinsertCount = (unsigned int)m_movedEntries.size();
+}
+
+/**
+*	@brief Find every pair of objects with overlapping bounds, each pair is only output once.
+*	NOTE: Uses the bounds from the last refit.
+*	@param a_jobSystem is the job system to split the queries across.
+*	@param a_pairs is the list to add found pairs to.
+*	@return void.
+*/
+void LooseOctree::FindPairs(JobSystem * a_jobSystem, std::vector<CollisionPair>& a_pairs)
+{
+	// Every moving object queries the tree independently, only keep pairs with a higher entry index or a static or sleeping object (they don't query) so each pair is found once
+	a_jobSystem->ParallelForCollect(m_entries.size(), PAIR_GRAIN_SIZE, m_threadPairs, a_pairs, [this](size_t a_index, std::vector<CollisionPair>& a_found) {
+		if (m_entries[a_index].obj->GetIsActive()) {
+			QueryCell(0, (unsigned int)a_index, a_found);
+		}
+	});
+}
+
+/**
+*	@brief Find every object living in a cell whose loose bounds touch a plane, skipping cells entirely on one side of it.
+*	NOTE: Only cells are checked against the plane, not the objects in them.
+*	@param a_normal is the direction the plane is facing in.
+*	@param a_dist is how far away from the origin the plane is.
+*	@param a_results is the list to add objects that could be touching the plane to.
+*	@return TRUE as the tree can always cull.
+*/
+bool LooseOctree::QueryPlane(const glm::vec3 & a_normal, float a_dist, std::vector<Rigidbody*>& a_results) const
+{
+	if (!m_cells.empty()) {
+		QueryPlaneCell(0, a_normal, a_dist, a_results);
+	}
+
+	return true;
+}
+
+/**
+*	@brief Draw an AABB for every cell holding objects.
+*	@param a_debugDraw is the debug draw sink to send the cells to.
+*	@param a_color is the color to draw the cells in.
+*	@return void.
+*/
+void LooseOctree::Draw(DebugDraw * a_debugDraw, const glm::vec4 & a_color) const
+{
+	for (auto& cell : m_cells) {
+
+		if (!cell.entries.empty()) {
+			a_debugDraw->AddAABB(cell.center, glm::vec3(cell.halfSize), a_color);
+		}
+	}
+}
+
+/**
+*	@brief Descend from a cell to the deepest cell whose loose bounds contain the entry and add it there, subdividing if it gets too full.
+*	@param a_entry is the index of the entry to place.
+*	@param a_startCell is the cell to start descending from, must contain the entry (or be the root).
+*	@return void.
+*/
+void LooseOctree::InsertEntry(unsigned int a_entry, int a_startCell)
+{
+	int			cell	= a_startCell;
+	glm::vec3	center	= (m_entries[a_entry].min + m_entries[a_entry].max) / 2.f;
+
+	// Only the child containing the object's center can contain the object as a whole
+	while (m_cells[cell].firstChild != -1) {
+		int child = ChildContaining(cell, center);
+
+		if (!LooseContains(child, m_entries[a_entry].min, m_entries[a_entry].max)) {
+			break;
+		}
+
+		cell = child;
+	}
+
+	m_entries[a_entry].cell = cell;
+	m_entries[a_entry].slot = (unsigned int)m_cells[cell].entries.size();
+	m_cells[cell].entries.push_back(a_entry);
+	AdjustSubtreeCount(cell, 1);
+
+	if (m_cells[cell].firstChild == -1 && m_cells[cell].entries.size() > m_splitThreshold && m_cells[cell].depth < m_maxDepth) {
+		Subdivide(cell);
+	}
+}
+
+/**
+*	@brief Remove an entry from its cell's entry list by moving the cell's last entry into its slot.
+*	@param a_entry is the index of the entry to detach.
+*	@return void.
+*/
+void LooseOctree::DetachEntry(unsigned int a_entry)
+{
+	Entry&			entry	= m_entries[a_entry];
+	Cell&			cell	= m_cells[entry.cell];
+	unsigned int	last	= cell.entries.back();
+
+	cell.entries[entry.slot]	= last;
+	m_entries[last].slot		= entry.slot;
+	cell.entries.pop_back();
+	AdjustSubtreeCount(entry.cell, -1);
+
+	entry.cell = -1;
+}
+
+/**
+*	@brief Create a cell's 8 children and push down every entry that fits in one of them.
+*	@param a_cell is the cell to split.
+*	@return void.
+*/
+void LooseOctree::Subdivide(int a_cell)
+{
+	int			firstChild	= (int)m_cells.size();
+	glm::vec3	center		= m_cells[a_cell].center;
+	float		childHalf	= m_cells[a_cell].halfSize / 2.f;
+
+	// Child index bits are the octant, x = 1, y = 2, z = 4 (set = positive side)
+	for (int i = 0; i < 8; ++i) {
+		Cell child;
+		child.center		= center + glm::vec3((i & 1) ? childHalf : -childHalf, (i & 2) ? childHalf : -childHalf, (i & 4) ? childHalf : -childHalf);
+		child.halfSize		= childHalf;
+		child.parent		= a_cell;
+		child.firstChild	= -1;
+		child.depth			= m_cells[a_cell].depth + 1;
+		child.subtreeCount	= 0;
+
+		m_cells.push_back(child);
+	}
+
+	m_cells[a_cell].firstChild = firstChild;
+
+	// Redistribute, entries that straddle the children stay in this cell
+	std::vector<unsigned int> entries;
+	entries.swap(m_cells[a_cell].entries);
+	AdjustSubtreeCount(a_cell, -(int)entries.size());
+
+	for (auto index : entries) {
+		InsertEntry(index, a_cell);
+	}
+}
+
+/**
+*	@brief Add to the entry count of a cell and every one of its ancestors.
+*	@param a_cell is the cell an entry was added to or removed from.
+*	@param a_delta is how many entries were added (negative if removed).
+*	@return void.
+*/
+void LooseOctree::AdjustSubtreeCount(int a_cell, int a_delta)
+{
+	for (int cell = a_cell; cell != -1; cell = m_cells[cell].parent) {
+		m_cells[cell].subtreeCount += a_delta;
+	}
+}
+
+/**
+*	@brief Recursively check an entry against the entries of a cell and its children, skipping cells that can't hold anything overlapping it.
+*	@param a_cell is the cell to check.
+*	@param a_entry is the index of the entry to check.
+*	@param a_pairs is the list to add found pairs to.
+*	@return void.
+*/
+void LooseOctree::QueryCell(int a_cell, unsigned int a_entry, std::vector<CollisionPair>& a_pairs) const
+{
+	const Entry& entry	= m_entries[a_entry];
+	const Cell&	 cell	= m_cells[a_cell];
+
+	// Children's loose bounds are inside their parent's, so the whole subtree can be skipped
+	if (cell.subtreeCount == 0 || !LooseOverlaps(a_cell, entry.min, entry.max)) {
+		return;
+	}
+
+	for (auto otherIndex : cell.entries) {
+		const Entry& other = m_entries[otherIndex];
+
+		if ((otherIndex > a_entry || (otherIndex != a_entry && !other.obj->GetIsActive())) &&
+			entry.min.x <= other.max.x && entry.max.x >= other.min.x &&
+			entry.min.y <= other.max.y && entry.max.y >= other.min.y &&
+			entry.min.z <= other.max.z && entry.max.z >= other.min.z)
+		{
+			a_pairs.push_back(CollisionPair{ entry.obj, other.obj });
+		}
+	}
+
+	if (cell.firstChild != -1) {
+		for (int i = 0; i < 8; ++i) {
+			QueryCell(cell.firstChild + i, a_entry, a_pairs);
+		}
+	}
+}
+
+/**
+*	@brief Recursively gather the objects living in a cell and its children whose loose bounds touch a plane.
+*	NOTE: The root is never skipped, it holds the objects that are outside of the tree.
+*	@param a_cell is the cell to check.
+*	@param a_normal is the direction the plane is facing in.
+*	@param a_dist is how far away from the origin the plane is.
+*	@param a_results is the list to add objects that could be touching the plane to.
+*	@return void.
+*/
+void LooseOctree::QueryPlaneCell(int a_cell, const glm::vec3 & a_normal, float a_dist, std::vector<Rigidbody*>& a_results) const
+{
+	const Cell& cell = m_cells[a_cell];
+
+	if (cell.subtreeCount == 0) {
+		return;
+	}
+
+	// Children's loose bounds are inside their parent's, so the whole subtree can be skipped
+	if (a_cell != 0) {
+		glm::vec3 looseHalf = glm::vec3(cell.halfSize * m_looseness);
+
+		if (!AABB::MinMaxTouchesPlane(cell.center - looseHalf, cell.center + looseHalf, a_normal, a_dist)) {
+			return;
+		}
+	}
+
+	for (auto entryIndex : cell.entries) {
+		a_results.push_back(m_entries[entryIndex].obj);
+	}
+
+	if (cell.firstChild != -1) {
+		for (int i = 0; i < 8; ++i) {
+			QueryPlaneCell(cell.firstChild + i, a_normal, a_dist, a_results);
+		}
+	}
+}
+
+/**
+*	@brief Find which child of a subdivided cell a point falls in.
+*	@param a_cell is the subdivided cell.
+*	@param a_point is the point to locate.
+*	@return Index of the child cell.
+*/
+int LooseOctree::ChildContaining(int a_cell, const glm::vec3 & a_point) const
+{
+	const Cell& cell = m_cells[a_cell];
+
+	int octant =
+		((a_point.x >= cell.center.x) ? 1 : 0) |
+		((a_point.y >= cell.center.y) ? 2 : 0) |
+		((a_point.z >= cell.center.z) ? 4 : 0);
+
+	return cell.firstChild + octant;
+}
+
+/**
+*	@brief Check if a box is fully inside a cell's loose bounds.
+*	@param a_cell is the cell to check against.
+*	@param a_min is the minimum point of the box.
+*	@param a_max is the maximum point of the box.
+*	@return TRUE: Box is inside loose bounds | FALSE: Box is partially or fully outside loose bounds
+*/
+bool LooseOctree::LooseContains(int a_cell, const glm::vec3 & a_min, const glm::vec3 & a_max) const
+{
+	const Cell& cell		= m_cells[a_cell];
+	float		looseHalf	= cell.halfSize * m_looseness;
+
+	return (a_min.x >= cell.center.x - looseHalf && a_max.x <= cell.center.x + looseHalf &&
+		a_min.y >= cell.center.y - looseHalf && a_max.y <= cell.center.y + looseHalf &&
+		a_min.z >= cell.center.z - looseHalf && a_max.z <= cell.center.z + looseHalf);
+}
+
+/**
+*	@brief Check if a box touches a cell's loose bounds.
+*	NOTE: The root always overlaps, it holds the objects that are outside of the tree.
+*	@param a_cell is the cell to check against.
+*	@param a_min is the minimum point of the box.
+*	@param a_max is the maximum point of the box.
+*	@return TRUE: Box overlaps loose bounds | FALSE: Box is outside loose bounds
+*/
+bool LooseOctree::LooseOverlaps(int a_cell, const glm::vec3 & a_min, const glm::vec3 & a_max) const
+{
+	if (a_cell == 0) {
+		return true;
+	}
+
+	const Cell& cell		= m_cells[a_cell];
+	float		looseHalf	= cell.halfSize * m_looseness;
+
+	return (a_min.x <= cell.center.x + looseHalf && a_max.x >= cell.center.x - looseHalf &&
+		a_min.y <= cell.center.y + looseHalf && a_max.y >= cell.center.y - looseHalf &&
+		a_min.z <= cell.center.z + looseHalf && a_max.z >= cell.center.z - looseHalf);
+}
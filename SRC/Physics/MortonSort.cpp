@@ -0,0 +1,110 @@
+#include "Physics/MortonSort.h"
+#include "Physics/JobSystem.h"
+#include <assert.h>
+#include <algorithm>
+
+using namespace Physebs;
+
+namespace {
+	const unsigned int DIGIT_BITS	= 8;
+	const unsigned int BUCKET_COUNT = 1 << DIGIT_BITS;
+
+	/**
+	*	@brief Spread the lower 21 bits of a value out so there are two zero bits between each of them.
+	*/
+	uint64_t SpreadBits(uint64_t a_value)
+	{
+		a_value &= 0x1fffff;
+		a_value = (a_value | a_value << 32) & 0x1f00000000ffffull;
+		a_value = (a_value | a_value << 16) & 0x1f0000ff0000ffull;
+		a_value = (a_value | a_value << 8)	& 0x100f00f00f00f00full;
+		a_value = (a_value | a_value << 4)	& 0x10c30c30c30c30c3ull;
+		a_value = (a_value | a_value << 2)	& 0x1249249249249249ull;
+
+		return a_value;
+	}
+}
+
+/**
+*	@brief Interleave the bits of three coordinates into a Morton code so nearby cells get nearby keys.
+*	NOTE: Each coordinate gets 21 bits, higher bits are dropped. The bit order matches octree child indices (x = 1, y = 2, z = 4),
+*	so sorting by key puts cells in the same order as a depth first octree traversal.
+*	@param a_x is the x coordinate.
+*	@param a_y is the y coordinate.
+*	@param a_z is the z coordinate.
+*	@return Morton code of the coordinates, using the lower 63 bits.
+*/
+uint64_t Physebs::MortonEncode(uint32_t a_x, uint32_t a_y, uint32_t a_z)
+{
+	return SpreadBits(a_x) | (SpreadBits(a_y) << 1) | (SpreadBits(a_z) << 2);
+}
+
+/**
+*	@brief Sort entries by key, entries with equal keys keep their order.
+*	NOTE: Only the lower a_keyBits bits of the keys are looked at, one pass is made per 8 bits.
+*	@param a_jobSystem is the job system to split the counting and scattering across.
+*	@param a_entries is the list to sort.
+*	@param a_keyBits is how many of the lowest key bits are used.
+*	@return void.
+*/
+void MortonSorter::Sort(JobSystem * a_jobSystem, std::vector<MortonEntry>& a_entries, unsigned int a_keyBits)
+{
+	assert(a_keyBits <= 64 && "Morton keys only have 64 bits.");
+
+	size_t count		= a_entries.size();
+	size_t chunkCount	= (count + SORT_GRAIN_SIZE - 1) / SORT_GRAIN_SIZE;
+
+	m_scratch.resize(count);
+	m_histograms.resize(chunkCount * BUCKET_COUNT);
+
+	std::vector<MortonEntry>* src = &a_entries;
+	std::vector<MortonEntry>* dst = &m_scratch;
+
+	for (unsigned int shift = 0; shift < a_keyBits; shift += DIGIT_BITS) {
+		/// 1. Count each chunk's digits
+		a_jobSystem->ParallelFor(chunkCount, 1, [this, src, shift, count](size_t a_begin, size_t a_end, unsigned int) {
+			for (size_t chunk = a_begin; chunk < a_end; ++chunk) {
+				unsigned int*	histogram	= &m_histograms[chunk * BUCKET_COUNT];
+				size_t			last		= std::min(count, (chunk + 1) * SORT_GRAIN_SIZE);
+
+				std::fill(histogram, histogram + BUCKET_COUNT, 0u);
+
+				for (size_t i = chunk * SORT_GRAIN_SIZE; i < last; ++i) {
+					histogram[((*src)[i].key >> shift) & (BUCKET_COUNT - 1)]++;
+				}
+			}
+		});
+
+		/// 2. Turn counts into where each chunk starts writing each digit (digit major so earlier chunks write first, keeping it stable)
+		unsigned int offset = 0;
+
+		for (unsigned int bucket = 0; bucket < BUCKET_COUNT; ++bucket) {
+			for (size_t chunk = 0; chunk < chunkCount; ++chunk) {
+				unsigned int& slot	= m_histograms[chunk * BUCKET_COUNT + bucket];
+				unsigned int bucketCount = slot;
+
+				slot	= offset;
+				offset	+= bucketCount;
+			}
+		}
+
+		/// 3. Scatter each chunk's entries into place
+		a_jobSystem->ParallelFor(chunkCount, 1, [this, src, dst, shift, count](size_t a_begin, size_t a_end, unsigned int) {
+			for (size_t chunk = a_begin; chunk < a_end; ++chunk) {
+				unsigned int*	offsets = &m_histograms[chunk * BUCKET_COUNT];
+				size_t			last	= std::min(count, (chunk + 1) * SORT_GRAIN_SIZE);
+
+				for (size_t i = chunk * SORT_GRAIN_SIZE; i < last; ++i) {
+					(*dst)[offsets[((*src)[i].key >> shift) & (BUCKET_COUNT - 1)]++] = (*src)[i];
+				}
+			}
+		});
+
+		std::swap(src, dst);
+	}
+
+	// An odd number of passes leaves the result in the scratch list, swap buffers rather than copy back
+	if (src != &a_entries) {
+		a_entries.swap(m_scratch);
+	}
+}
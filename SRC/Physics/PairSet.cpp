@@ -0,0 +1,68 @@
+#include "Physics/PairSet.h"
+#include <assert.h>
+#include <algorithm>
+
+using namespace Physebs;
+
+namespace {
+	const uint64_t EMPTY_KEY = ~0ull;		// Would need both ids to be ~0u, a pair of an object with itself
+}
+
+/**
+*	@brief Empty the set and make sure the table can hold the given number of pairs while staying at most half full.
+*	NOTE: The table only ever grows so memory is reused between steps.
+*	@param a_maxPairs is the most pairs that will be inserted before the next reset.
+*	@return void.
+*/
+void PairSet::Reset(size_t a_maxPairs)
+{
+	size_t tableSize = m_keys.empty() ? 64 : m_keys.size();
+
+	while (tableSize < a_maxPairs * 2) {
+		tableSize *= 2;
+	}
+
+	if (tableSize != m_keys.size()) {
+		m_keys.resize(tableSize);
+
+		m_shift = 64;
+		for (size_t size = tableSize; size > 1; size >>= 1) {
+			--m_shift;
+		}
+	}
+
+	std::fill(m_keys.begin(), m_keys.end(), EMPTY_KEY);
+
+	m_count		= 0;
+	m_maxPairs	= a_maxPairs;
+}
+
+/**
+*	@brief Add a pair of ids to the set, order doesn't matter.
+*	@param a_first is the id of one object of the pair.
+*	@param a_second is the id of the other object of the pair.
+*	@return TRUE pair was added || FALSE pair was already in the set
+*/
+bool PairSet::Insert(unsigned int a_first, unsigned int a_second)
+{
+	assert(m_count < m_maxPairs && "Inserted more pairs into a pair set than it was reset for.");
+
+	// Lower id in the high bits so both orders give the same key
+	uint64_t key = (a_first < a_second) ? ((uint64_t)a_first << 32 | a_second) : ((uint64_t)a_second << 32 | a_first);
+
+	size_t mask = m_keys.size() - 1;
+	size_t slot = (size_t)((key * 0x9E3779B97F4A7C15ull) >> m_shift);
+
+	while (m_keys[slot] != EMPTY_KEY) {
+		if (m_keys[slot] == key) {
+			return false;
+		}
+
+		slot = (slot + 1) & mask;
+	}
+
+	m_keys[slot] = key;
+	++m_count;
+
+	return true;
+}
@@ -1,6 +1,7 @@
 #include "Physics/Plane.h"
-#include <Gizmos.h>
+#include "Physics/DebugDraw.h"
 #include <glm/ext.hpp>
+#include <cfloat>
 
 using namespace Physebs;
 
@@ -23,7 +24,7 @@ Plane::~Plane()
 {
 }
 
-void Plane::Draw()
+void Plane::Draw(DebugDraw* a_debugDraw)
 {
 	// 1. Find center position of plane using normal and distance
 	glm::vec3 planePos = m_normal * m_originDist;
@@ -37,39 +38,45 @@ void Plane::Draw()
 	glm::vec3 v3 = planePos + (planeLineDir2 * PLANE_DRAW);
 	glm::vec3 v4 = planePos - (planeLineDir2 * PLANE_DRAW);
 
-	aie::Gizmos::addTri(v1, v2, v3, m_color);
-	aie::Gizmos::addTri(v4, v2, v1, m_color);
+	a_debugDraw->AddTri(v1, v2, v3, m_color);
+	a_debugDraw->AddTri(v4, v2, v1, m_color);
 }
 
-void Plane::Update(float a_dt)
+/**
+*	@brief Planes are infinite so their bounds cover all of space.
+*	NOTE: Broadphases skip planes and check them against every other object separately.
+*	@param a_min is set to the lowest representable point.
+*	@param a_max is set to the highest representable point.
+*	@return void.
+*/
+void Plane::CalculateBounds(glm::vec3 & a_min, glm::vec3 & a_max) const
 {
-	// Static rigidbodies do not move
-	if (b_dynamic) {
-		// Apply dampening (negative velocity scaled by friction)
-		ApplyForce(-m_vel * m_frict);
-
-		// Calculate velocity
-		m_vel += m_accel * a_dt;
-
-		// Truncate velocity with an epsilon
-		if (glm::length(m_vel) < EPSILON) {
-			// Zero out velocity to avoid floating point errors
-			m_vel = glm::vec3();
-		}
+	a_min = glm::vec3(-FLT_MAX);
+	a_max = glm::vec3(FLT_MAX);
+}
 
-		/// Calculate distance from origin
-		// Dot-product velocity vector with normal to determine whether velocity its positive or negative
-		float	velDotCheck = glm::dot(m_normal, m_vel * a_dt);
-		bool	b_negVel	= (velDotCheck < 0) ? true : false;
-		float	velLength	= glm::length(velDotCheck);
+/**
+*	@brief Move the plane along its normal by the velocity the scene integrated this step.
+*	NOTE: Called by the scene after the body integration sweep, planes are positioned by distance from origin rather than position.
+*	@param a_dt is the fixed time step the velocity was integrated with.
+*	@return void.
+*/
+void Plane::UpdateOriginDist(float a_dt)
+{
+	// Static and sleeping planes do not move
+	if (!GetIsActive()) {
+		return;
+	}
 
-		// Convert velocity into single float and negate if velocity is negative to plane normal
-		m_originDist += (b_negVel) ? -velLength : velLength;
+	/// Calculate distance from origin
+	// Dot-product velocity vector with normal to determine whether velocity its positive or negative
+	float	velDotCheck = glm::dot(m_normal, GetVel() * a_dt);
+	bool	b_negVel	= (velDotCheck < 0) ? true : false;
+	float	velLength	= glm::length(velDotCheck);
 
-		/// Calculate position
-		m_pos = m_normal * m_originDist;
-	}
+	// Convert velocity into single float and negate if velocity is negative to plane normal
+	m_originDist += (b_negVel) ? -velLength : velLength;
 
-	// Reset acceleration so it gets re-calculated (regardless of static or dynamic)
-	m_accel = glm::vec3();
+	/// Calculate position
+	SetPos(m_normal * m_originDist);
 }
@@ -1,5 +1,4 @@
-#include "Physics\Rigidbody.h"
-#include <Gizmos.h>
+#include "Physics/Rigidbody.h"
 #include <glm/vec4.hpp>
 #include <glm/ext.hpp>
 
@@ -35,8 +34,10 @@ Rigidbody::~Rigidbody()
 */
 void Rigidbody::ApplyForce(const glm::vec3& a_force)
 {
+	Wake();
+
 	// f = m * a | a = f / m
-	m_accel += a_force / m_mass;
+	AccelData() += a_force * GetInvMass();
 }
 
 /**
@@ -46,29 +47,32 @@ void Rigidbody::ApplyForce(const glm::vec3& a_force)
 */
 void Rigidbody::ApplyImpulseForce(const glm::vec3 & a_force)
 {
-	m_vel += a_force / m_mass;
+	Wake();
+
+	VelData() += a_force * GetInvMass();
 }
 
-void Rigidbody::Update(float a_dt)
+/**
+*	@brief Set the mass, keeping the scene store's inverse mass in step.
+*	@param a_mass is the new mass.
+*	@return void.
+*/
+void Rigidbody::SetMass(float a_mass)
 {
-	// Static rigidbodies do not move
-	if (b_dynamic) {
-		// Apply dampening (negative velocity scaled by friction)
-		ApplyForce(-m_vel * m_frict);
-
-		// Calculate velocity
-		m_vel += m_accel * a_dt;
-
-		// Truncate velocity with an epsilon
-		if (glm::length(m_vel) < EPSILON) {
-			// Zero out velocity to avoid floating point errors
-			m_vel = glm::vec3();
-		}
+	MassData() = a_mass;
 
-		// Calculate position
-		m_pos += m_vel * a_dt;
+	if (m_store) {
+		m_store->invMass[m_storeIndex] = 1.f / a_mass;
 	}
+}
 
-	// Reset acceleration so it gets re-calculated (regardless of static or dynamic)
-	m_accel = glm::vec3();
+/**
+*	@brief Wake the body along with the rest of its sleeping island, so bodies resting on each other wake together.
+*	@return void.
+*/
+void Rigidbody::Wake()
+{
+	if (m_store && m_store->asleep[m_storeIndex].value) {
+		m_store->WakeIsland(m_store->island[m_storeIndex]);
+	}
 }
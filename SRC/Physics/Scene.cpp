@@ -1,23 +1,321 @@
-#include "Physics\Scene.h"
-#include "Physics\Rigidbody.h"
-#include "Physics\Sphere.h"
-#include "Physics\Plane.h"
-#include "Physics\AABB.h"
-#include "Physics\Spring.h"
-#include "Octree\Octree.h"
+#include "Physics/Scene.h"
+#include "Physics/CollisionDispatch.h"
+#include "Physics/Rigidbody.h"
+#include "Physics/Sphere.h"
+#include "Physics/Plane.h"
+#include "Physics/AABB.h"
+#include "Physics/Spring.h"
+#include "Octree/Octree.h"
 #include <glm/ext.hpp>
 #include <assert.h>
 #include <algorithm>
 #include <random>
+#include <cmath>
+#include <cstdio>
+#include <chrono>
 #include "PhysebsUtility_Funcs.h"
+#include "PhysebsUtility_Simd.h"
 
 using namespace Physebs;
 using namespace tinyxml2;
 
+namespace {
+	/**
+	*	@brief Check a batch of SIMD_WIDTH objects against a plane at once by comparing their distance from it with how far they reach along its normal.
+	*	NOTE: Objects within PLANE_CULL_SLACK of touching the plane pass too, anything found still needs the exact check.
+	*	@param a_x, a_y, a_z are the objects' positions.
+	*	@param a_radius is the objects' radii.
+	*	@param a_halfX, a_halfY, a_halfZ are the objects' half extents.
+	*	@param a_normal is the direction the plane is facing in.
+	*	@param a_dist is how far away from the origin the plane is.
+	*	@return Bit mask of the objects that could be touching the plane, bit 0 is the first object.
+	*/
+	int PlaneTouchMask(const float* a_x, const float* a_y, const float* a_z, const float* a_radius,
+		const float* a_halfX, const float* a_halfY, const float* a_halfZ, const glm::vec3& a_normal, float a_dist)
+	{
+#if PHYSEBS_SSE
+		__m128 centerDist = _mm_add_ps(_mm_add_ps(
+			_mm_mul_ps(_mm_set1_ps(a_normal.x), _mm_loadu_ps(a_x)),
+			_mm_mul_ps(_mm_set1_ps(a_normal.y), _mm_loadu_ps(a_y))),
+			_mm_mul_ps(_mm_set1_ps(a_normal.z), _mm_loadu_ps(a_z)));
+		centerDist = _mm_sub_ps(centerDist, _mm_set1_ps(a_dist));
+
+		__m128 reach = _mm_add_ps(_mm_add_ps(
+			_mm_mul_ps(_mm_set1_ps(std::abs(a_normal.x)), _mm_loadu_ps(a_halfX)),
+			_mm_mul_ps(_mm_set1_ps(std::abs(a_normal.y)), _mm_loadu_ps(a_halfY))),
+			_mm_mul_ps(_mm_set1_ps(std::abs(a_normal.z)), _mm_loadu_ps(a_halfZ)));
+		reach = _mm_add_ps(_mm_add_ps(reach, _mm_loadu_ps(a_radius)), _mm_set1_ps(PLANE_CULL_SLACK));
+
+		// Clear the sign bits for the absolute distance
+		__m128 absDist = _mm_andnot_ps(_mm_set1_ps(-0.f), centerDist);
+
+		return _mm_movemask_ps(_mm_cmple_ps(absDist, reach));
+#else
+		int mask = 0;
+
+		for (int i = 0; i < SIMD_WIDTH; ++i) {
+			float centerDist	= a_normal.x * a_x[i] + a_normal.y * a_y[i] + a_normal.z * a_z[i] - a_dist;
+			float reach			= std::abs(a_normal.x) * a_halfX[i] + std::abs(a_normal.y) * a_halfY[i] + std::abs(a_normal.z) * a_halfZ[i] + a_radius[i] + PLANE_CULL_SLACK;
+
+			if (std::abs(centerDist) <= reach) {
+				mask |= 1 << i;
+			}
+		}
+
+		return mask;
+#endif
+	}
+
+	static_assert(sizeof(glm::vec3) == 3 * sizeof(float), "Integration kernel reads the body store's vectors as packed floats.");
+
+#if PHYSEBS_SSE
+	/**
+	*	@brief Load four packed vec3s (x0 y0 z0 x1 | y1 z1 x2 y2 | z2 x3 y3 z3) into one register per axis.
+	*	@param a_src is the first float of the first vector.
+	*	@param a_x, a_y, a_z are the registers to load each axis into.
+	*	@return void.
+	*/
+	inline void LoadVec3x4(const float* a_src, __m128& a_x, __m128& a_y, __m128& a_z)
+	{
+		__m128 a = _mm_loadu_ps(a_src);
+		__m128 b = _mm_loadu_ps(a_src + 4);
+		__m128 c = _mm_loadu_ps(a_src + 8);
+
+		a_x = _mm_shuffle_ps(a, _mm_shuffle_ps(b, c, _MM_SHUFFLE(1, 1, 2, 2)), _MM_SHUFFLE(2, 0, 3, 0));
+		a_y = _mm_shuffle_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(0, 0, 1, 1)), _mm_shuffle_ps(b, c, _MM_SHUFFLE(2, 2, 3, 3)), _MM_SHUFFLE(2, 0, 2, 0));
+		a_z = _mm_shuffle_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(1, 1, 2, 2)), c, _MM_SHUFFLE(3, 0, 2, 0));
+	}
+
+	/**
+	*	@brief Store one register per axis back as four packed vec3s, see LoadVec3x4.
+	*	@param a_dst is the first float of the first vector.
+	*	@param a_x, a_y, a_z are the registers holding each axis.
+	*	@return void.
+	*/
+	inline void StoreVec3x4(float* a_dst, __m128 a_x, __m128 a_y, __m128 a_z)
+	{
+		_mm_storeu_ps(a_dst,		_mm_shuffle_ps(_mm_shuffle_ps(a_x, a_y, _MM_SHUFFLE(0, 0, 0, 0)), _mm_shuffle_ps(a_z, a_x, _MM_SHUFFLE(1, 1, 0, 0)), _MM_SHUFFLE(2, 0, 2, 0)));
+		_mm_storeu_ps(a_dst + 4,	_mm_shuffle_ps(_mm_shuffle_ps(a_y, a_z, _MM_SHUFFLE(1, 1, 1, 1)), _mm_shuffle_ps(a_x, a_y, _MM_SHUFFLE(2, 2, 2, 2)), _MM_SHUFFLE(2, 0, 2, 0)));
+		_mm_storeu_ps(a_dst + 8,	_mm_shuffle_ps(_mm_shuffle_ps(a_z, a_x, _MM_SHUFFLE(3, 3, 2, 2)), _mm_shuffle_ps(a_y, a_z, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(2, 0, 2, 0)));
+	}
+#endif
+
+	/**
+	*	@brief Apply gravity, the pending global force and friction dampening to a body then integrate its velocity and position.
+	*	NOTE: Static and sleeping bodies only have their acceleration reset. Does the same operations in the same order as IntegrateBatch so both give identical results.
+	*	@param a_bodies is the store holding the body.
+	*	@param a_index is the body's store index.
+	*	@param a_gravity is the acceleration due to gravity.
+	*	@param a_force is the global force applied since the last step.
+	*	@param a_dt is the time step.
+	*	@return void.
+	*/
+	void IntegrateBody(BodyStore& a_bodies, size_t a_index, const glm::vec3& a_gravity, const glm::vec3& a_force, float a_dt)
+	{
+		if (a_bodies.dynamic[a_index].value && !a_bodies.asleep[a_index].value) {
+			float invMass	= a_bodies.invMass[a_index];
+			float damping	= a_bodies.frict[a_index] * invMass;
+
+			// Gravity accelerates every mass the same, forces and dampening (negative velocity scaled by friction) are scaled by inverse mass
+			glm::vec3 accel = a_bodies.accel[a_index] + (a_gravity + a_force * invMass) - a_bodies.vel[a_index] * damping;
+			glm::vec3 vel	= a_bodies.vel[a_index] + accel * a_dt;
+
+			// Zero out velocity below an epsilon to avoid floating point errors
+			if (vel.x * vel.x + vel.y * vel.y + vel.z * vel.z < EPSILON * EPSILON) {
+				vel = glm::vec3();
+			}
+
+			a_bodies.vel[a_index] = vel;
+			a_bodies.pos[a_index] += vel * a_dt;
+		}
+
+		a_bodies.accel[a_index] = glm::vec3();
+	}
+
+	/**
+	*	@brief Integrate SIMD_WIDTH bodies at once, see IntegrateBody.
+	*	NOTE: Bodies' vectors are transposed into one register per axis, static and sleeping bodies are masked out of the writes rather than branched around.
+	*	@param a_first is the store index of the first body in the batch.
+	*	@return void.
+	*/
+	void IntegrateBatch(BodyStore& a_bodies, size_t a_first, const glm::vec3& a_gravity, const glm::vec3& a_force, float a_dt)
+	{
+#if PHYSEBS_SSE
+		float* pos		= &a_bodies.pos[a_first].x;
+		float* vel		= &a_bodies.vel[a_first].x;
+		float* accel	= &a_bodies.accel[a_first].x;
+
+		const BodyStore::Flag* dynamic	= &a_bodies.dynamic[a_first];
+		const BodyStore::Flag* asleep	= &a_bodies.asleep[a_first];
+
+		// Sleeping bodies are masked out the same as static ones
+		__m128 isDynamic	= _mm_castsi128_ps(_mm_cmpgt_epi32(_mm_setr_epi32(
+			dynamic[0].value && !asleep[0].value, dynamic[1].value && !asleep[1].value, dynamic[2].value && !asleep[2].value, dynamic[3].value && !asleep[3].value), _mm_setzero_si128()));
+		__m128 invMass		= _mm_loadu_ps(&a_bodies.invMass[a_first]);
+		__m128 damping		= _mm_mul_ps(_mm_loadu_ps(&a_bodies.frict[a_first]), invMass);
+		__m128 dt			= _mm_set1_ps(a_dt);
+
+		// Keep the new value for dynamic bodies and the old one for static bodies
+		auto select = [isDynamic](__m128 a_new, __m128 a_old) {
+			return _mm_or_ps(_mm_and_ps(isDynamic, a_new), _mm_andnot_ps(isDynamic, a_old));
+		};
+
+		__m128 posX, posY, posZ, velX, velY, velZ, accelX, accelY, accelZ;
+		LoadVec3x4(pos, posX, posY, posZ);
+		LoadVec3x4(vel, velX, velY, velZ);
+		LoadVec3x4(accel, accelX, accelY, accelZ);
+
+		accelX = _mm_sub_ps(_mm_add_ps(accelX, _mm_add_ps(_mm_set1_ps(a_gravity.x), _mm_mul_ps(_mm_set1_ps(a_force.x), invMass))), _mm_mul_ps(velX, damping));
+		accelY = _mm_sub_ps(_mm_add_ps(accelY, _mm_add_ps(_mm_set1_ps(a_gravity.y), _mm_mul_ps(_mm_set1_ps(a_force.y), invMass))), _mm_mul_ps(velY, damping));
+		accelZ = _mm_sub_ps(_mm_add_ps(accelZ, _mm_add_ps(_mm_set1_ps(a_gravity.z), _mm_mul_ps(_mm_set1_ps(a_force.z), invMass))), _mm_mul_ps(velZ, damping));
+
+		__m128 newVelX = _mm_add_ps(velX, _mm_mul_ps(accelX, dt));
+		__m128 newVelY = _mm_add_ps(velY, _mm_mul_ps(accelY, dt));
+		__m128 newVelZ = _mm_add_ps(velZ, _mm_mul_ps(accelZ, dt));
+
+		// Squared speed against squared epsilon, avoiding the square root
+		__m128 speedSq	= _mm_add_ps(_mm_add_ps(_mm_mul_ps(newVelX, newVelX), _mm_mul_ps(newVelY, newVelY)), _mm_mul_ps(newVelZ, newVelZ));
+		__m128 isMoving = _mm_cmpnlt_ps(speedSq, _mm_set1_ps(EPSILON * EPSILON));
+
+		newVelX = _mm_and_ps(newVelX, isMoving);
+		newVelY = _mm_and_ps(newVelY, isMoving);
+		newVelZ = _mm_and_ps(newVelZ, isMoving);
+
+		StoreVec3x4(pos, select(_mm_add_ps(posX, _mm_mul_ps(newVelX, dt)), posX), select(_mm_add_ps(posY, _mm_mul_ps(newVelY, dt)), posY), select(_mm_add_ps(posZ, _mm_mul_ps(newVelZ, dt)), posZ));
+		StoreVec3x4(vel, select(newVelX, velX), select(newVelY, velY), select(newVelZ, velZ));
+		StoreVec3x4(accel, _mm_setzero_ps(), _mm_setzero_ps(), _mm_setzero_ps());
+#else
+		for (size_t i = a_first; i < a_first + SIMD_WIDTH; ++i) {
+			IntegrateBody(a_bodies, i, a_gravity, a_force, a_dt);
+		}
+#endif
+	}
+
+	/**
+	*	@brief Work out the force a spring puts on its objects from how far it is from its resting length (Hooke's law), dampened by the objects' relative velocity.
+	*	NOTE: Static objects count as still. Does the same operations in the same order as SpringForceBatch so both give identical results.
+	*	@param a_springs is the store holding the spring, its force is written back into it.
+	*	@param a_bodies is the store holding the spring's objects.
+	*	@param a_index is the spring's store index.
+	*	@return void.
+	*/
+	void SpringForce(SpringStore& a_springs, const BodyStore& a_bodies, size_t a_index)
+	{
+		unsigned int actor = a_springs.actor[a_index];
+		unsigned int other = a_springs.other[a_index];
+
+		// Other - actor, the direction the other end is pulled in when stretched
+		glm::vec3	springVec		= a_bodies.pos[other] - a_bodies.pos[actor];
+		float		length			= std::sqrt(springVec.x * springVec.x + springVec.y * springVec.y + springVec.z * springVec.z);
+		float		retractScale	= a_springs.springiness[a_index] * (a_springs.restLength[a_index] - length);
+
+		float		actorMoves		= a_bodies.dynamic[actor].value ? 1.f : 0.f;
+		float		otherMoves		= a_bodies.dynamic[other].value ? 1.f : 0.f;
+		glm::vec3	relativeVel		= a_bodies.vel[other] * otherMoves - a_bodies.vel[actor] * actorMoves;
+
+		a_springs.force[a_index] = springVec * retractScale - relativeVel * a_springs.dampening[a_index];
+	}
+
+	/**
+	*	@brief Work out the forces of SIMD_WIDTH springs at once, see SpringForce.
+	*	NOTE: The springs' attributes are loaded straight from the store, their objects' vectors are gathered into one register per axis.
+	*	@param a_first is the store index of the first spring in the batch.
+	*	@return void.
+	*/
+	void SpringForceBatch(SpringStore& a_springs, const BodyStore& a_bodies, size_t a_first)
+	{
+#if PHYSEBS_SSE
+		const unsigned int* actor = &a_springs.actor[a_first];
+		const unsigned int* other = &a_springs.other[a_first];
+
+		auto gather = [](const std::vector<glm::vec3>& a_src, const unsigned int* a_indices, __m128& a_x, __m128& a_y, __m128& a_z) {
+			const glm::vec3& v0 = a_src[a_indices[0]];
+			const glm::vec3& v1 = a_src[a_indices[1]];
+			const glm::vec3& v2 = a_src[a_indices[2]];
+			const glm::vec3& v3 = a_src[a_indices[3]];
+
+			a_x = _mm_setr_ps(v0.x, v1.x, v2.x, v3.x);
+			a_y = _mm_setr_ps(v0.y, v1.y, v2.y, v3.y);
+			a_z = _mm_setr_ps(v0.z, v1.z, v2.z, v3.z);
+		};
+
+		// 1 for dynamic objects and 0 for static ones
+		auto moves = [&a_bodies](const unsigned int* a_indices) {
+			__m128i isDynamic = _mm_setr_epi32(a_bodies.dynamic[a_indices[0]].value, a_bodies.dynamic[a_indices[1]].value, a_bodies.dynamic[a_indices[2]].value, a_bodies.dynamic[a_indices[3]].value);
+
+			return _mm_and_ps(_mm_castsi128_ps(_mm_cmpgt_epi32(isDynamic, _mm_setzero_si128())), _mm_set1_ps(1.f));
+		};
+
+		__m128 actorX, actorY, actorZ, otherX, otherY, otherZ;
+		gather(a_bodies.pos, actor, actorX, actorY, actorZ);
+		gather(a_bodies.pos, other, otherX, otherY, otherZ);
+
+		__m128 springX = _mm_sub_ps(otherX, actorX);
+		__m128 springY = _mm_sub_ps(otherY, actorY);
+		__m128 springZ = _mm_sub_ps(otherZ, actorZ);
+
+		__m128 length		= _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(springX, springX), _mm_mul_ps(springY, springY)), _mm_mul_ps(springZ, springZ)));
+		__m128 retractScale = _mm_mul_ps(_mm_loadu_ps(&a_springs.springiness[a_first]), _mm_sub_ps(_mm_loadu_ps(&a_springs.restLength[a_first]), length));
+
+		__m128 actorMoves = moves(actor);
+		__m128 otherMoves = moves(other);
+
+		gather(a_bodies.vel, actor, actorX, actorY, actorZ);
+		gather(a_bodies.vel, other, otherX, otherY, otherZ);
+
+		__m128 relativeX = _mm_sub_ps(_mm_mul_ps(otherX, otherMoves), _mm_mul_ps(actorX, actorMoves));
+		__m128 relativeY = _mm_sub_ps(_mm_mul_ps(otherY, otherMoves), _mm_mul_ps(actorY, actorMoves));
+		__m128 relativeZ = _mm_sub_ps(_mm_mul_ps(otherZ, otherMoves), _mm_mul_ps(actorZ, actorMoves));
+
+		__m128 dampening = _mm_loadu_ps(&a_springs.dampening[a_first]);
+
+		StoreVec3x4(&a_springs.force[a_first].x,
+			_mm_sub_ps(_mm_mul_ps(springX, retractScale), _mm_mul_ps(relativeX, dampening)),
+			_mm_sub_ps(_mm_mul_ps(springY, retractScale), _mm_mul_ps(relativeY, dampening)),
+			_mm_sub_ps(_mm_mul_ps(springZ, retractScale), _mm_mul_ps(relativeZ, dampening)));
+#else
+		for (size_t i = a_first; i < a_first + SIMD_WIDTH; ++i) {
+			SpringForce(a_springs, a_bodies, i);
+		}
+#endif
+	}
+
+	/**
+	*	@brief Run a function over every item of a coloring, a batch at a time with each batch split across threads.
+	*	NOTE: Items of a batch don't share a body so the order they run in doesn't change anything, the serial batch runs on the calling thread in order.
+	*	@param a_jobSystem is the threads to split batches across.
+	*	@param a_batches is the coloring of the items.
+	*	@param a_fn is called as a_fn(unsigned int a_item) for every item.
+	*	@return void.
+	*/
+	template <class Fn>
+	void SolveBatches(JobSystem* a_jobSystem, const BatchColoring& a_batches, const Fn& a_fn)
+	{
+		for (size_t batch = 0; batch < a_batches.GetBatchCount(); ++batch) {
+			const unsigned int* items = a_batches.GetBatch(batch);
+			size_t				count = a_batches.GetBatchSize(batch);
+
+			if (a_batches.GetIsBatchSerial(batch)) {
+				for (size_t i = 0; i < count; ++i) {
+					a_fn(items[i]);
+				}
+
+				continue;
+			}
+
+			a_jobSystem->ParallelFor(count, SOLVER_GRAIN_SIZE, [items, &a_fn](size_t a_begin, size_t a_end, unsigned int) {
+				for (size_t i = a_begin; i < a_end; ++i) {
+					a_fn(items[i]);
+				}
+			});
+		}
+	}
+}
+
 Scene::Scene(const glm::vec3 & a_gravityForce, const glm::vec3& a_globalForce, 
-	const glm::vec3& a_simulationOrigin, const glm::vec3& a_simulationHalfExtents) 
+	const glm::vec3& a_simulationOrigin, const glm::vec3& a_simulationHalfExtents, unsigned int a_threadCount) 
 	: 
-	m_gravity(a_gravityForce), m_globalForce(a_globalForce)
+	m_gravity(a_gravityForce), m_globalForce(a_globalForce), m_pendingGlobalForce()
 {
 	// Defaults for 100fps
 	m_fixedTimeStep		= 0.01f;		// One-hundreth of a second
@@ -29,22 +327,28 @@ Scene::Scene(const glm::vec3 & a_gravityForce, const glm::vec3& a_globalForce,
 	float minCellSize[3]	= MIN_VOLUME_SIZE;
 
 	m_spatialPartitionTree = new Octree<PartitionNode>(simulationMin, simulationMax, minCellSize);
+
+	m_broadphases[BRUTE_FORCE]		= new BruteForce();
+	m_broadphases[LOOSE_OCTREE]		= new LooseOctree(a_simulationOrigin, a_simulationHalfExtents);
+	m_broadphases[SWEEP_AND_PRUNE]	= new SweepAndPrune();
+	m_broadphases[SPATIAL_HASH]		= new SpatialHash();
+	m_broadphases[AABB_TREE]		= new AABBTree();
+
+	m_jobSystem = new JobSystem(a_threadCount);
 }
 
 Scene::~Scene()
 {
-	// Objects are under responsibility of the scene now, free their allocated memory
-	for (auto obj : m_objects) {
-		delete obj;
-	}
+	// Objects and constraints are freed along with their pools
 
-	// Free memory held by all constraints
-	for (auto constraint : m_constraints) {
-		delete constraint;
+	// Free memory held by partition trees
+	delete m_spatialPartitionTree;
+	for (auto broadphase : m_broadphases) {
+		delete broadphase;
 	}
 
-	// Free memory held by partition tree
-	delete m_spatialPartitionTree;
+	// Join worker threads
+	delete m_jobSystem;
 }
 
 /**
@@ -66,130 +370,488 @@ void Scene::FixedUpdate(float a_dt)
 }
 
 void Scene::Update() {
-	ApplyGravity();
+	// Objects and constraints created or destroyed from here on are queued until the step is done, so nothing changes under the loops below
+	b_inStep = true;
 
 	// Regardless of how long update takes to be called, time between frames will be consistent now
-	for (auto obj : m_objects) {
-		obj->Update(m_fixedTimeStep);			
-	}
+	IntegrateBodies();
 
-	for (auto constraint : m_constraints) {
-		constraint->Update();
-	}
+	UpdateConstraints();
 
 	// Detect and resolve collisions after calculating object movement
 	/// Octree optimisation, segments objects into volumes and checks only objects in that volume
-	if (b_partitionCollisions) {
+	if (m_broadphase == OCTREE) {
 		PartitionCollisions();
 	}
 
-	/// O(n^2) complexity, checks every single object in scene against every other object
+	/// Every other broadphase persists between steps and finds the pairs to check itself
+	///	- BRUTE_FORCE:		O(n^2) complexity, checks the bounds of every single object against every other object
+	///	- LOOSE_OCTREE:		Same as the octree but objects only move once they leave their volume's loosened bounds
+	///	- SWEEP_AND_PRUNE:	Sorted intervals along an axis, only re-sorted as far as objects moved past each other
+	///	- SPATIAL_HASH:		Hashed uniform grid, only cells with objects in them exist so there are no simulation boundaries
+	///	- AABB_TREE:		Bounding volume hierarchy, objects only move in the tree once they escape their fattened bounds
 	else {
-		// In case partitioning is switched off in real-time make sure partition tree is clear
+		// In case the broadphase is switched in real-time make sure the rebuilt partition tree is clear
 		m_spatialPartitionTree->clear();
 
-		DetectCollisions(m_objects);
+		BroadphaseCollisions(m_broadphase);
+	}
+
+	if (b_autoBroadphase) {
+		UpdateAutoBroadphase();
+	}
+
+	if (b_allowSleep) {
+		WakeTouchedIslands();
 	}
 
 	ResolveCollisions();
+
+	// Group what touched into islands and put the ones that have come to rest to sleep
+	UpdateIslands();
+
+	// Collisions have been resolved for this frame, clear all recorded collisions
+	m_collisions.clear();
+
+	b_inStep = false;
+
+	// Apply every structural change made during the step in one go (e.g. objects culled for leaving the simulation)
+	FlushCommands();
 }
 
+/**
+*	@brief Send debug geometry for objects, constraints and partition volumes to the debug draw sink.
+*	NOTE: Does nothing if no debug draw sink has been set (e.g. headless builds).
+*/
 void Scene::Draw()
 {
+	if (m_debugDraw == nullptr) {
+		return;
+	}
+
 	// Attach gizmos to objects
 	for (auto obj : m_objects) {
-		obj->Draw();
+		obj->Draw(m_debugDraw);
 	}
 
 	// Represent constraints
 	for (auto constraint : m_constraints) {
-		constraint->Draw();
+		constraint->Draw(m_debugDraw);
 	}
 
 	// Draw AABB Gizmos to represent partition volumes
 #if B_SHOW_PARTITIONS
-	OctreeCallbackDebug ocd;
+	m_spatialPartitionTree->visit(OctreeVisitorDebug(m_debugDraw));
 
-	m_spatialPartitionTree->traverse(&ocd);
+	if (m_broadphases[m_broadphase] != nullptr) {
+		m_broadphases[m_broadphase]->Draw(m_debugDraw, glm::vec4(1, 0, 0, 1.f));
+	}
 #endif
 }
 
 /**
-*	@brief Add an object for the scene to manage (already existing).
+*	@brief Add an object for the scene to manage (already constructed in its pool).
 *	@param a_obj is the object to add.
 *	@return void.
 */
 void Scene::AddObject(Rigidbody * a_obj)
 {
 	m_objects.push_back(a_obj);
+	m_objectConstraints.emplace_back();
+
+	// Move physics state into the scene's contiguous storage, objects are kept in the same order so an object's store index is also its index here
+	m_bodies.Add(a_obj);
+
+	for (auto broadphase : m_broadphases) {
+		if (broadphase != nullptr) {
+			broadphase->Insert(a_obj);
+		}
+	}
+
+	if (a_obj->GetShape() == PLANE) {
+		m_planes.push_back(static_cast<Plane*>(a_obj));
+	}
+
+	// Give the object a handle, reusing a free entry of the handle map if there is one
+	unsigned int slotIndex = m_freeHandleSlot;
+
+	if (slotIndex != ~0u) {
+		m_freeHandleSlot = m_handleSlots[slotIndex].nextFree;
+	}
+	else {
+		slotIndex = (unsigned int)m_handleSlots.size();
+		m_handleSlots.push_back(HandleSlot{ nullptr, 0, ~0u });
+	}
+
+	m_handleSlots[slotIndex].obj	= a_obj;
+	a_obj->m_handle.index			= slotIndex;
+	a_obj->m_handle.generation		= m_handleSlots[slotIndex].generation;
+
+	// Kept alongside any other objects with the same ID
+	m_idLookup.emplace(a_obj->GetID(), a_obj);
 }
 
 /**
-*	@brief Find and remove an object from the scene (do not delete memory, no longer responsible for object)
+*	@brief Remove an object from the scene (its memory is freed by DestroyObject)
+*	NOTE: O(1) apart from destroying the object's constraints, the last object is swapped into its place.
 *	@param a_obj is the object to remove.
 *	@return void.
 */
 void Scene::RemoveObject(Rigidbody * a_obj)
 {
+	unsigned int index = a_obj->GetStoreIndex();
 
-	// Find corresponding iterator to object pointer and remove from vector
-	auto foundIter = std::find(m_objects.begin(), m_objects.end(), a_obj);
-	
-	assert(foundIter != m_objects.end() && "Attempted to remove object from scene that it does not own.");
-	
-	m_objects.erase(foundIter);
-	
-	// If connected via constraint, remove and delete attached constraint
-	for (auto constraint : m_constraints) {
-	
-		if (constraint->ContainsObj(a_obj)) {
-	
-			RemoveConstraint(constraint);
-			delete constraint;
+	assert(a_obj->m_store == &m_bodies && m_objects[index] == a_obj && "Attempted to remove object from scene that it does not own.");
+
+	// If connected via constraint, destroy attached constraint (the object's list is taken first as destroying them changes it)
+	std::vector<Constraint*> attached;
+	attached.swap(m_objectConstraints[index]);
+
+	for (auto constraint : attached) {
+		DestroyConstraint(constraint);
+	}
+
+	// Swap last object into the hole, the body store does the same so indices stay matched
+	m_objects[index] = m_objects.back();
+	m_objects.pop_back();
+
+	m_objectConstraints[index].swap(m_objectConstraints.back());
+	m_objectConstraints.pop_back();
+
+	// Give physics state back to the object so it stays valid outside of the scene
+	m_bodies.Remove(a_obj);
+
+	// Springs of the object swapped into the hole refer to it by store index, point them at its new slot
+	if (index < m_objects.size()) {
+		for (auto constraint : m_objectConstraints[index]) {
+			if (constraint->GetType() == SPRING) {
+				m_springs.UpdateBodies(static_cast<Spring*>(constraint));
+			}
+		}
+	}
+
+	for (auto broadphase : m_broadphases) {
+		if (broadphase != nullptr) {
+			broadphase->Remove(a_obj);
+		}
+	}
+
+	if (a_obj->GetShape() == PLANE) {
+		m_planes.erase(std::find(m_planes.begin(), m_planes.end(), static_cast<Plane*>(a_obj)));
+	}
+
+	// Free the object's handle map entry, bumping its generation so existing handles go stale
+	HandleSlot& slot = m_handleSlots[a_obj->m_handle.index];
+
+	slot.obj		= nullptr;
+	slot.generation++;
+	slot.nextFree	= m_freeHandleSlot;
+
+	m_freeHandleSlot	= a_obj->m_handle.index;
+	a_obj->m_handle		= BodyHandle();
+
+	RemoveIDLookup(a_obj);
+}
+
+/**
+*	@brief Remove an object from the scene and free it back into the pool for its shape.
+*	NOTE: Any constraints attached to the object are destroyed too. During a step this is queued until the step is done.
+*	@param a_obj is the object to destroy.
+*	@return void.
+*/
+void Scene::DestroyObject(Rigidbody * a_obj)
+{
+	// Mid-step, queue it along with its constraints (ahead of it, so they are already gone when it is removed)
+	if (b_inStep) {
+		if (!a_obj->b_destroyQueued) {
+			if (a_obj->m_store == &m_bodies) {
+				for (auto constraint : m_objectConstraints[a_obj->GetStoreIndex()]) {
+					DestroyConstraint(constraint);
+				}
+			}
+
+			a_obj->b_destroyQueued = true;
+			m_commands.push_back(SceneCommand{ DESTROY_OBJECT, a_obj, nullptr });
 		}
+
+		return;
 	}
+
+	RemoveObject(a_obj);
+
+	switch (a_obj->GetShape())
+	{
+		case SPHERE:
+			std::get<ObjectPool<Sphere>>(m_pools).Destroy(static_cast<Sphere*>(a_obj));
+			break;
+		case PLANE:
+			std::get<ObjectPool<Plane>>(m_pools).Destroy(static_cast<Plane*>(a_obj));
+			break;
+		case AA_BOX:
+			std::get<ObjectPool<AABB>>(m_pools).Destroy(static_cast<AABB*>(a_obj));
+			break;
+		default:
+			assert(false && "Attempted to destroy an object with no pool for its shape.");
+	}
+}
+
+/**
+*	@brief Destroy a list of objects, see DestroyObject.
+*	NOTE: O(k) for k objects (plus their constraints), each removal swaps the last object into its place rather than shifting the rest.
+*	@param a_objs is the objects to destroy.
+*	@return void.
+*/
+void Scene::DestroyObjects(const std::vector<Rigidbody*>& a_objs)
+{
+	for (auto obj : a_objs) {
+		DestroyObject(obj);
+	}
+}
+
+/**
+*	@brief Reserve capacity for the object lists, body store and lookups so adding up to the given number of objects doesn't reallocate.
+*	@param a_count is the total number of objects to make room for.
+*	@return void.
+*/
+void Scene::ReserveObjects(size_t a_count)
+{
+	m_objects.reserve(a_count);
+	m_objectConstraints.reserve(a_count);
+	m_bodies.Reserve(a_count);
+	m_handleSlots.reserve(a_count);
+	m_idLookup.reserve(a_count);
 }
 
 /**
-*	@brief Add a constraint to the scene to manage and enforce (already existing).
+*	@brief Add a constraint to the scene to manage and enforce (already constructed in its pool).
+*	NOTE: Both attached objects must already be in the scene.
 *	@param a_constraint is the constraint to add
 *	@return void.
 */
 void Scene::AddConstraint(Constraint * a_constraint)
 {
+	Rigidbody* actor = a_constraint->GetAttachedActor();
+	Rigidbody* other = a_constraint->GetAttachedOther();
+
+	assert(actor != nullptr && other != nullptr && "Attempted to add a constraint that isn't attached to two objects.");
+
+	a_constraint->m_sceneIndex = (unsigned int)m_constraints.size();
 	m_constraints.push_back(a_constraint);
+
+	// Springs are evaluated all at once from the spring store
+	if (a_constraint->GetType() == SPRING) {
+		m_springs.Add(static_cast<Spring*>(a_constraint));
+	}
+
+	// Remember the constraint on each object so removing the object finds it without checking every constraint
+	m_objectConstraints[actor->GetStoreIndex()].push_back(a_constraint);
+
+	if (other != actor) {
+		m_objectConstraints[other->GetStoreIndex()].push_back(a_constraint);
+	}
 }
 
 /**
-*	@brief Find and remove a constraint from the scene (do not delete memory, no longer responsible for constraint)
+*	@brief Remove a constraint from the scene (its memory is freed by DestroyConstraint)
+*	NOTE: O(1) apart from removing it from its objects' constraint lists, the last constraint is swapped into its place.
 *	@param a_constraint is the constraint to remove.
 *	@return void.
 */
 void Scene::RemoveConstraint(Constraint * a_constraint)
 {
-	// Find corresponding iterator to constraint pointer and remove from vector
-	auto foundIter = std::find(m_constraints.begin(), m_constraints.end(), a_constraint);
+	unsigned int index = a_constraint->m_sceneIndex;
+
+	assert(index < m_constraints.size() && m_constraints[index] == a_constraint && "Attempted to remove constraint from scene that it does not own.");
+
+	m_constraints[index] = m_constraints.back();
+	m_constraints[index]->m_sceneIndex = index;
+	m_constraints.pop_back();
+
+	if (a_constraint->GetType() == SPRING) {
+		m_springs.Remove(static_cast<Spring*>(a_constraint));
+	}
+
+	// Take it off each attached object's list
+	for (Rigidbody* obj : { a_constraint->GetAttachedActor(), a_constraint->GetAttachedOther() }) {
+		std::vector<Constraint*>& attached	= m_objectConstraints[obj->GetStoreIndex()];
+		auto foundIter						= std::find(attached.begin(), attached.end(), a_constraint);
+
+		if (foundIter != attached.end()) {
+			*foundIter = attached.back();
+			attached.pop_back();
+		}
+	}
+}
+
+/**
+*	@brief Remove a constraint from the scene and free it back into the pool for its type.
+*	NOTE: During a step this is queued until the step is done.
+*	@param a_constraint is the constraint to destroy.
+*	@return void.
+*/
+void Scene::DestroyConstraint(Constraint * a_constraint)
+{
+	if (b_inStep) {
+		if (!a_constraint->b_destroyQueued) {
+			a_constraint->b_destroyQueued = true;
+			m_commands.push_back(SceneCommand{ DESTROY_CONSTRAINT, nullptr, a_constraint });
+		}
+
+		return;
+	}
 
-	assert(foundIter != m_constraints.end() && "Attempted to remove constraint from scene that it does not own.");
+	RemoveConstraint(a_constraint);
+	FreeConstraint(a_constraint);
+}
 
-	m_constraints.erase(foundIter);
+/**
+*	@brief Free a constraint back into the pool for its type, it must not be in the scene.
+*	@param a_constraint is the constraint to free.
+*	@return void.
+*/
+void Scene::FreeConstraint(Constraint * a_constraint)
+{
+	switch (a_constraint->GetType())
+	{
+		case SPRING:
+			std::get<ObjectPool<Spring>>(m_pools).Destroy(static_cast<Spring*>(a_constraint));
+			break;
+		default:
+			assert(false && "Attempted to destroy a constraint with no pool for its type.");
+	}
 }
 
 /**
 *	@brief Find the first Rigidbody that has the given id and return it.
+*	NOTE: If IDs are shared the object earliest in the object list is returned.
 *	@param a_id is the id to compare with.
 *	@return Pointer to found Rigidbody or nullptr if no Rigidbodies have that ID.
 */
-Rigidbody * Scene::GetObjectByID(unsigned int a_id)
+Rigidbody * Scene::GetObjectByID(unsigned int a_id) const
 {
-	for (auto obj : m_objects) {
-		
-		if (obj->GetID() == a_id) {
-			return obj;
+	Rigidbody* found = nullptr;
+	auto range = m_idLookup.equal_range(a_id);
+
+	for (auto iter = range.first; iter != range.second; ++iter) {
+		if (found == nullptr || iter->second->GetStoreIndex() < found->GetStoreIndex()) {
+			found = iter->second;
+		}
+	}
+
+	return found;
+}
+
+/**
+*	@brief Find the object a handle refers to.
+*	@param a_handle is the handle to look up.
+*	@return Pointer to the object or nullptr if it has been removed from the scene since the handle was taken.
+*/
+Rigidbody * Scene::GetObjectByHandle(BodyHandle a_handle) const
+{
+	if (a_handle.index >= m_handleSlots.size() || m_handleSlots[a_handle.index].generation != a_handle.generation) {
+		return nullptr;
+	}
+
+	return m_handleSlots[a_handle.index].obj;
+}
+
+/**
+*	@brief Change the ID of an object in the scene, keeping the ID lookup in step.
+*	@param a_obj is the object to change.
+*	@param a_id is its new ID.
+*	@return void.
+*/
+void Scene::SetObjectID(Rigidbody * a_obj, unsigned int a_id)
+{
+	RemoveIDLookup(a_obj);
+
+	a_obj->SetID(a_id);
+	m_idLookup.emplace(a_id, a_obj);
+}
+
+/**
+*	@brief Take an object out of the ID lookup, other objects sharing its ID stay findable.
+*	@param a_obj is the object to take out.
+*	@return void.
+*/
+void Scene::RemoveIDLookup(Rigidbody * a_obj)
+{
+	auto range = m_idLookup.equal_range(a_obj->GetID());
+
+	for (auto iter = range.first; iter != range.second; ++iter) {
+		if (iter->second == a_obj) {
+			m_idLookup.erase(iter);
+			return;
+		}
+	}
+}
+
+/**
+*	@brief Apply the creations and destructions queued during the step, in the order they were made.
+*	NOTE: Room for every added object and constraint is reserved once up front.
+*	@return void.
+*/
+void Scene::FlushCommands()
+{
+	if (m_commands.empty()) {
+		return;
+	}
+
+	size_t objectCount		= m_objects.size();
+	size_t constraintCount	= m_constraints.size();
+
+	for (auto& command : m_commands) {
+		objectCount		+= command.type == ADD_OBJECT;
+		constraintCount += command.type == ADD_CONSTRAINT;
+	}
+
+	ReserveObjects(objectCount);
+	m_constraints.reserve(constraintCount);
+	m_springs.Reserve(constraintCount);
+
+	for (auto& command : m_commands) {
+		switch (command.type)
+		{
+			case ADD_OBJECT:
+				AddObject(command.obj);
+				break;
+			case DESTROY_OBJECT:
+				DestroyObject(command.obj);
+				break;
+			case ADD_CONSTRAINT:
+				AddConstraint(command.constraint);
+				break;
+			case DESTROY_CONSTRAINT:
+				DestroyConstraint(command.constraint);
+				break;
+			case DISCARD_CONSTRAINT:
+				FreeConstraint(command.constraint);
+				break;
 		}
 	}
 
-	return nullptr;
+	m_commands.clear();
+}
+
+/**
+*	@brief Free every handle map entry, bumping their generations so every existing handle goes stale.
+*	@return void.
+*/
+void Scene::ReleaseHandles()
+{
+	m_freeHandleSlot = ~0u;
+
+	for (unsigned int i = (unsigned int)m_handleSlots.size(); i-- > 0;) {
+		HandleSlot& slot = m_handleSlots[i];
+
+		if (slot.obj != nullptr) {
+			slot.obj = nullptr;
+			slot.generation++;
+		}
+
+		slot.nextFree		= m_freeHandleSlot;
+		m_freeHandleSlot	= i;
+	}
 }
 
 /**
@@ -227,19 +889,19 @@ XMLError Scene::SaveScene(const char * a_fileName)
 		rbElement->SetAttribute("restitution", obj->GetRestitution());
 
 		char pos[256];
-		sprintf_s(pos, "%4.4f,%4.4f,%4.4f", obj->GetPos().x, obj->GetPos().y, obj->GetPos().z);
+		snprintf(pos, sizeof(pos), "%4.4f,%4.4f,%4.4f", obj->GetPos().x, obj->GetPos().y, obj->GetPos().z);
 		rbElement->SetAttribute("pos", pos);
 
 		char vel[256];
-		sprintf_s(vel, "%4.4f,%4.4f,%4.4f", obj->GetVel().x, obj->GetVel().y, obj->GetVel().z);
+		snprintf(vel, sizeof(vel), "%4.4f,%4.4f,%4.4f", obj->GetVel().x, obj->GetVel().y, obj->GetVel().z);
 		rbElement->SetAttribute("vel", vel);
 
 		char accel[256];
-		sprintf_s(accel, "%4.4f,%4.4f,%4.4f", obj->GetAccel().x, obj->GetAccel().y, obj->GetAccel().z);
+		snprintf(accel, sizeof(accel), "%4.4f,%4.4f,%4.4f", obj->GetAccel().x, obj->GetAccel().y, obj->GetAccel().z);
 		rbElement->SetAttribute("accel", accel);
 
 		char color[256];
-		sprintf_s(color, "%4.4f,%4.4f,%4.4f,%4.4f", obj->GetColor().r, obj->GetColor().g, obj->GetColor().b, obj->GetColor().a);
+		snprintf(color, sizeof(color), "%4.4f,%4.4f,%4.4f,%4.4f", obj->GetColor().r, obj->GetColor().g, obj->GetColor().b, obj->GetColor().a);
 		rbElement->SetAttribute("color", color);
 
 		/// Sphere attributes
@@ -249,7 +911,7 @@ XMLError Scene::SaveScene(const char * a_fileName)
 			rbElement->SetAttribute("radius", sphere->GetRadius());
 
 			char dimensions[256];
-			sprintf_s(dimensions, "%i,%i", sphere->GetDimensions().x, sphere->GetDimensions().y);
+			snprintf(dimensions, sizeof(dimensions), "%i,%i", sphere->GetDimensions().x, sphere->GetDimensions().y);
 			rbElement->SetAttribute("dimensions", dimensions);
 		}
 
@@ -260,7 +922,7 @@ XMLError Scene::SaveScene(const char * a_fileName)
 			rbElement->SetAttribute("originDist", plane->GetDist());
 
 			char normal[256];
-			sprintf_s(normal, "%4.4f,%4.4f,%4.4f", plane->GetNormal().x, plane->GetNormal().y, plane->GetNormal().z);
+			snprintf(normal, sizeof(normal), "%4.4f,%4.4f,%4.4f", plane->GetNormal().x, plane->GetNormal().y, plane->GetNormal().z);
 			rbElement->SetAttribute("normal", normal);
 		}
 
@@ -269,7 +931,7 @@ XMLError Scene::SaveScene(const char * a_fileName)
 			AABB* box = static_cast<AABB*>(obj);
 
 			char extents[256];
-			sprintf_s(extents, "%4.4f,%4.4f,%4.4f", box->GetExtents().x, box->GetExtents().y, box->GetExtents().z);
+			snprintf(extents, sizeof(extents), "%4.4f,%4.4f,%4.4f", box->GetExtents().x, box->GetExtents().y, box->GetExtents().z);
 			rbElement->SetAttribute("extents", extents);
 		}
 
@@ -297,7 +959,7 @@ XMLError Scene::SaveScene(const char * a_fileName)
 		ctElement->SetAttribute("attachedOtherID", constraint->GetAttachedOther()->GetID());
 
 		char color[256];
-		sprintf_s(color, "%4.4f,%4.4f,%4.4f,%4.4f", constraint->GetColor().r, constraint->GetColor().g, constraint->GetColor().b, constraint->GetColor().a);
+		snprintf(color, sizeof(color), "%4.4f,%4.4f,%4.4f,%4.4f", constraint->GetColor().r, constraint->GetColor().g, constraint->GetColor().b, constraint->GetColor().a);
 		ctElement->SetAttribute("color", color);
 
 		/// Spring attributes
@@ -329,16 +991,27 @@ XMLError Scene::SaveScene(const char * a_fileName)
 */
 XMLError Scene::LoadScene(const char * a_fileName)
 {
-	/// 1. Clear current constraints and objects before loading new ones (including dynamically allocated memory)
-	for (auto constraint : m_constraints) {
-		delete constraint;
-	}
+	/// 1. Clear current constraints and objects before loading new ones, their pools are reset at once instead of freeing each one
+	m_commands.clear();
 	m_constraints.clear();
-	
-	for (auto obj : m_objects) {
-		delete obj;
-	}
 	m_objects.clear();
+	m_objectConstraints.clear();
+	m_contactCache.clear();
+	m_idLookup.clear();
+	ReleaseHandles();
+	m_planes.clear();
+	m_bodies.Clear();
+	m_springs.Clear();
+	for (auto broadphase : m_broadphases) {
+		if (broadphase != nullptr) {
+			broadphase->Clear();
+		}
+	}
+
+	std::get<ObjectPool<Sphere>>(m_pools).Reset();
+	std::get<ObjectPool<Plane>>(m_pools).Reset();
+	std::get<ObjectPool<AABB>>(m_pools).Reset();
+	std::get<ObjectPool<Spring>>(m_pools).Reset();
 
 	/// 2. Create empty XML document and attempt to load in data
 	XMLDocument sceneFile;
@@ -422,10 +1095,8 @@ XMLError Scene::LoadScene(const char * a_fileName)
 			if (!StringToGLMVec2(attributeText, dimensions)) { return XML_ERROR_PARSING_TEXT; }
 
 			// Construct sphere and add to scene
-			Sphere* newSphere = new Sphere(radius, dimensions, pos, mass, frict, b_dynamic, color, restitution);
-			newSphere->SetID(id);				// Override automatic ID assignment in favor of the value saved for consistency with the constraints
-
-			AddObject(newSphere);
+			Sphere* newSphere = CreateObject<Sphere>(radius, dimensions, pos, mass, frict, b_dynamic, color, restitution);
+			SetObjectID(newSphere, id);			// Override automatic ID assignment in favor of the value saved for consistency with the constraints
 		}
 
 		/// Plane attributes
@@ -441,10 +1112,8 @@ XMLError Scene::LoadScene(const char * a_fileName)
 			if (!StringToGLMVec3(attributeText, normal)) { return XML_ERROR_PARSING_TEXT; }
 
 			// Construct plane and add to scene
-			Plane* newPlane = new Plane(normal, originDist, pos, mass, frict, b_dynamic, color, restitution);
-			newPlane->SetID(id);
-
-			AddObject(newPlane);
+			Plane* newPlane = CreateObject<Plane>(normal, originDist, pos, mass, frict, b_dynamic, color, restitution);
+			SetObjectID(newPlane, id);
 		}
 
 		/// AABB attributes
@@ -456,10 +1125,8 @@ XMLError Scene::LoadScene(const char * a_fileName)
 			if (!StringToGLMVec3(attributeText, extents)) { return XML_ERROR_PARSING_TEXT; }
 
 			// Construct AABB and add to scene
-			AABB* newBox = new AABB(extents, pos, mass, frict, b_dynamic, color, restitution);
-			newBox->SetID(id);
-
-			AddObject(newBox);
+			AABB* newBox = CreateObject<AABB>(extents, pos, mass, frict, b_dynamic, color, restitution);
+			SetObjectID(newBox, id);
 		}
 
 		// Iterate to next Rigidbody
@@ -510,8 +1177,12 @@ XMLError Scene::LoadScene(const char * a_fileName)
 			float dampening;
 			eResult = ctElement->QueryFloatAttribute("dampening", &dampening);
 
+			Rigidbody* attachedActor = GetObjectByID(attachedActorID);
+			Rigidbody* attachedOther = GetObjectByID(attachedOtherID);
+			if (attachedActor == nullptr || attachedOther == nullptr) return XML_ERROR_PARSING_ATTRIBUTE;		// Attached to an object that isn't in the file
+
 			// Construct spring and add to scene
-			AddConstraint(new Spring(GetObjectByID(attachedActorID), GetObjectByID(attachedOtherID), color, springiness, restLength, dampening));
+			CreateConstraint<Spring>(attachedActor, attachedOther, color, springiness, restLength, dampening);
 		}
 
 		// Iterate to next Constraint
@@ -525,135 +1196,283 @@ XMLError Scene::LoadScene(const char * a_fileName)
 
 }
 
+/**
+*	@brief Change the gravity applied to every dynamic object.
+*	NOTE: Sleeping objects are skipped by integration, so every island is woken when gravity actually changes or objects resting under the old gravity would never feel the new one.
+*	@param a_gravity is the new gravity force.
+*	@return void.
+*/
+void Scene::SetGravity(const glm::vec3 & a_gravity)
+{
+	if (a_gravity != m_gravity) {
+		m_gravity = a_gravity;
+		m_bodies.WakeAll();
+	}
+}
+
 /**
 *	@brief Apply defined force to every object in the scene.
+*	NOTE: The force is only queued, the next step's integration adds it to every object so the bodies aren't swept an extra time.
+*	NOTE: Sleeping objects are skipped by integration, so every island is woken if the force isn't zero.
 *	@return void.
 */
 void Scene::ApplyGlobalForce()
 {
-	for (auto obj : m_objects) {
-		obj->ApplyForce(m_globalForce);
+	if (m_globalForce != glm::vec3()) {
+		m_pendingGlobalForce += m_globalForce;
+		m_bodies.WakeAll();
 	}
 }
 
 /**
-*	@brief Use all object positions to build octree with collision volumes within the simulation boundaries and segment collision detection between those volumes for 400% more efficiency.
-*	NOTE: If an object is outside of the simulation boundaries it will be removed AND deleted.
-*	detect collisions between each set of objects in their respective collision volumes.
+*	@brief Use all object bounds to build octree with collision volumes within the simulation boundaries and only check objects that share a volume for 400% more efficiency.
+*	NOTE: If an object is outside of the simulation boundaries it will be removed AND destroyed once the step is done.
+*	NOTE: Objects are added to every volume their bounds overlap, pairs sharing several volumes are only checked once.
+*	@return void.
 */
 void Scene::PartitionCollisions()
 {
-	// Refresh volumes in tree to account for change in object positions
-	m_spatialPartitionTree->clear();
+	auto start = std::chrono::steady_clock::now();
+
+	m_partitionEntries.clear();
 
-	// Calculate volumes to encompass object positions and add corresponding object pointers to 'segment' the scene
+	// Gather objects to partition, objects outside of the simulation extents are queued to be removed from the scene as well as destroyed
 	for (auto currentObj : m_objects) {
 		float objPos[3] = { currentObj->GetPos().x, currentObj->GetPos().y, currentObj->GetPos().z };
 
-		// Object is outside of simulation extents, remove it from scene as well as delete it, and continue to next one to avoid accessing deleted memory
+		// Object is outside of simulation extents, destroy it once the step is done (the list being iterated doesn't change until then) and leave it out of the partition
 		if (!AABB::PointInMinMax(objPos, m_spatialPartitionTree->GetMin(), m_spatialPartitionTree->GetMax())) {
 
-			RemoveObject(currentObj);
-			delete currentObj;
+			DestroyObject(currentObj);
 
 			continue;
 		}
 
-		else {
-#if 1
-			/// Get Partition nodes from the octants that contain the object and add the object to it. NOTE: Nodes will always be initialised on pre-existing or newly created octant.
-			std::vector<PartitionNode*> collidingOctantNodes;
-
-			// Object is AABB, get nodes by using corners
-			if (currentObj->GetShape() == AA_BOX) {
-				AABB* box = static_cast<AABB*>(currentObj);
+		// Object is plane, skip object in order to avoid duplicate collision detections as planes are infinite and are globally checked
+		if (currentObj->GetShape() == PLANE) {
+			continue;
+		}
 
-				for (auto corner : box->CalculateCorners()) {
-					float cornerPos[3] = { corner.x, corner.y, corner.z };
+		PartitionEntry entry;
+		entry.obj = currentObj;
 
-					// Ensure position isn't out of simulation bounds, if it is then remove the object from scene and delete it and continue to avoid accessing deleted memory
-					if (!AABB::PointInMinMax(cornerPos, m_spatialPartitionTree->GetMin(), m_spatialPartitionTree->GetMax())) {
+		m_partitionEntries.push_back(entry);
+	}
 
-						RemoveObject(currentObj);
-						delete currentObj;
+	// Smallest volumes form a grid over the simulation extents, find the range of them each object's bounds overlap
+	int depth = m_spatialPartitionTree->getLeafDepth();
+	unsigned int lastCell = (1u << depth) - 1;
 
-						continue;
-					}
+	glm::vec3 treeMin = glm::vec3(m_spatialPartitionTree->GetMin()[0], m_spatialPartitionTree->GetMin()[1], m_spatialPartitionTree->GetMin()[2]);
+	glm::vec3 treeMax = glm::vec3(m_spatialPartitionTree->GetMax()[0], m_spatialPartitionTree->GetMax()[1], m_spatialPartitionTree->GetMax()[2]);
+	glm::vec3 cellScale = glm::vec3((float)(1u << depth)) / (treeMax - treeMin);
 
-					PartitionNode& cornerNode = m_spatialPartitionTree->getCell(cornerPos);
-					// Add scene poitner to node so detect collisions can be called later
-					cornerNode.scene = this;
+	m_jobSystem->ParallelFor(m_partitionEntries.size(), JOB_GRAIN_SIZE, [&](size_t a_begin, size_t a_end, unsigned int) {
+		for (size_t i = a_begin; i < a_end; ++i) {
+			PartitionEntry& entry = m_partitionEntries[i];
+			entry.obj->CalculateBounds(entry.min, entry.max);
 
-					// No duplicate nodes
-					if (std::find(collidingOctantNodes.begin(), collidingOctantNodes.end(), &cornerNode) == collidingOctantNodes.end()) {
-						collidingOctantNodes.push_back(&cornerNode);
-					}
+			// Parts poking out of the simulation extents are kept in the outermost volumes
+			glm::vec3 cellMin = (entry.min - treeMin) * cellScale;
+			glm::vec3 cellMax = (entry.max - treeMin) * cellScale;
 
-				}
-			}
-			// Object is plane, skip object in order to avoid duplicate collision detections as planes are infinite and are globally checked
-			else if (currentObj->GetShape() == PLANE) {
-				continue;
-			}
-			// Regular object, use center pos to get node
-			else {
-				PartitionNode& posNode = m_spatialPartitionTree->getCell(objPos);
-				posNode.scene = this;
-				collidingOctantNodes.push_back(&posNode);
+			for (int axis = 0; axis < 3; ++axis) {
+				entry.cellMin[axis] = (unsigned int)Clamp(cellMin[axis], (float)lastCell, 0.f);
+				entry.cellMax[axis] = (unsigned int)Clamp(cellMax[axis], (float)lastCell, 0.f);
 			}
+		}
+	});
 
-			// Add object to all unique colliding octant nodes
-			for (auto node : collidingOctantNodes) {
-				node->containedObjects.push_back(currentObj);
-			}
-#else
-			// Object is AABB, get nodes by using min and max
-			if (currentObj->GetShape() == AA_BOX) {
-				AABB* box = static_cast<AABB*>(currentObj);
-				float min[3] = { box->CalculateMin().x, box->CalculateMin().y, box->CalculateMin().z };
-				float max[3] = { box->CalculateMax().x, box->CalculateMax().x, box->CalculateMax().z };
-
-				// Find or create nodes based off the points representing the AABBs overall volume
-				PartitionNode& minNode = m_spatialPartitionTree->getCell(min);
-				// Add scene pointer to node so detect collisions function can be called later
-				minNode.scene = this;
-				minNode.containedObjects.push_back(currentObj);
-
-				PartitionNode& maxNode = m_spatialPartitionTree->getCell(max);
-				maxNode.scene = this;
-
-				// Only add object to max node if it isn't a duplicate of min (memory addresses aren't the same)
-				if (&maxNode != &minNode) {
-					maxNode.containedObjects.push_back(currentObj);
-				}
-				else {
-					bool stop = true;
+	// Give each object a slot for every volume it overlaps
+	size_t keyCount = 0;
+
+	for (auto& entry : m_partitionEntries) {
+		entry.firstKey = keyCount;
+		keyCount += (size_t)(entry.cellMax[0] - entry.cellMin[0] + 1) * (entry.cellMax[1] - entry.cellMin[1] + 1) * (entry.cellMax[2] - entry.cellMin[2] + 1);
+	}
+
+	m_partitionKeys.resize(keyCount);
+
+	m_jobSystem->ParallelFor(m_partitionEntries.size(), JOB_GRAIN_SIZE, [this](size_t a_begin, size_t a_end, unsigned int) {
+		for (size_t i = a_begin; i < a_end; ++i) {
+			const PartitionEntry& entry = m_partitionEntries[i];
+			MortonEntry* key = &m_partitionKeys[entry.firstKey];
+
+			for (unsigned int z = entry.cellMin[2]; z <= entry.cellMax[2]; ++z) {
+				for (unsigned int y = entry.cellMin[1]; y <= entry.cellMax[1]; ++y) {
+					for (unsigned int x = entry.cellMin[0]; x <= entry.cellMax[0]; ++x) {
+						*key++ = MortonEntry{ MortonEncode(x, y, z), (unsigned int)i };
+					}
 				}
 			}
-			// Object is plane, skip object in order to avoid duplicate collision detections as planes are infinite and are globally checked
-			else if (currentObj->GetShape() == PLANE) {
-				continue;
-			}
-			// Regular object, use center pos to get node
-			else {
-				PartitionNode& posNode = m_spatialPartitionTree->getCell(objPos);
-				posNode.scene = this;
-				posNode.containedObjects.push_back(currentObj);
-			}
+		}
+	});
 
-#endif
-			/// Change object colors to reflect what volume they are in
-#if B_VOLUME_COLORS 
-			// Assign object to volume color
-			currentObj->SetColor(n.debugColor);
-#endif
+	// Sorting by key groups each volume's objects together in octree order (stable, so objects stay in scene order within a volume), then the tree is built straight from the runs of equal keys
+	m_partitionSorter.Sort(m_jobSystem, m_partitionKeys, 3 * depth);
+
+	m_spatialPartitionTree->buildLeaves(m_partitionKeys.size(), [this](size_t a_index) { return m_partitionKeys[a_index].key; },
+		[this](size_t a_first, size_t a_last, PartitionNode& a_nodeData) {
+			// Add scene pointer to node to mark it as holding objects
+			a_nodeData.scene = this;
+			a_nodeData.firstKey = (unsigned int)a_first;
+			a_nodeData.keyCount = (unsigned int)(a_last - a_first);
+		});
+
+	// Volumes are independent, split the tree's top levels across threads and find overlapping objects in each volume (merged in traversal order so the pairs are in the same order no matter how many threads ran)
+	m_partitionPairs.clear();
+
+	m_spatialPartitionTree->visitLeavesParallel([this](size_t a_partCount, const auto& a_visitPart) {
+		m_jobSystem->ParallelForCollect(a_partCount, 1, m_threadPartitionPairs, m_partitionPairs, a_visitPart);
+	}, OctreeVisitorFindPairs(this));
+
+	// Objects sharing several volumes were found in each of them, only keep the first time each pair was found so it is resolved once
+	m_partitionPairSet.Reset(m_partitionPairs.size());
+	m_collisionPairs.clear();
+
+	for (auto& pair : m_partitionPairs) {
+		if (m_partitionPairSet.Insert(pair.first, pair.second)) {
+			m_collisionPairs.push_back(CollisionPair{ m_partitionEntries[pair.first].obj, m_partitionEntries[pair.second].obj });
+		}
+	}
+
+	m_broadphaseTimes[OCTREE] = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+	m_refitBroadphase = OCTREE;
+
+	DetectPairCollisions(m_collisionPairs, m_collisions);
+	DetectPlaneCollisions(nullptr, m_collisions);
+}
+
+/**
+*	@brief Catch a persistent broadphase up with the objects' new positions and only check the pairs it finds, then check planes separately.
+*	NOTE: The loose octree culls objects outside of the simulation boundaries first, the same as PartitionCollisions does, as it is bounded by them.
+*	The other persistent broadphases have no simulation boundaries, so nothing is culled and objects outside of them are kept.
+*	NOTE: The time taken to refit and find pairs is recorded for auto selection, the narrowphase is left out as it is the same for every broadphase.
+*	@param a_broadphase is which broadphase to find pairs with, can't be the octree.
+*	@return void.
+*/
+void Scene::BroadphaseCollisions(eBroadphase a_broadphase)
+{
+	Broadphase* broadphase = m_broadphases[a_broadphase];
+
+	assert(broadphase != nullptr && "Attempted to find pairs with a broadphase the scene does not keep persistently.");
+
+	if (a_broadphase == LOOSE_OCTREE) {
+		CullObjects();
+	}
+
+	auto start = std::chrono::steady_clock::now();
+
+	// Sleeping objects haven't moved since they fell asleep, their bounds are only still current if this broadphase was the one refit last step
+	broadphase->Refit(m_jobSystem, m_refitBroadphase == a_broadphase);
+	m_refitBroadphase = a_broadphase;
+
+	m_collisionPairs.clear();
+	broadphase->FindPairs(m_jobSystem, m_collisionPairs);
+
+	m_broadphaseTimes[a_broadphase] = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+	DetectPairCollisions(m_collisionPairs, m_collisions);
+	DetectPlaneCollisions(broadphase, m_collisions);
+}
+
+/**
+*	@brief Queue every object outside of the simulation boundaries to be removed AND destroyed once the step is done, for the loose octree.
+*	NOTE: The loose octree is bounded by the simulation, without this objects that left it would pile up in its root cell, which every query walks.
+*	@return void.
+*/
+void Scene::CullObjects()
+{
+	const float* simulationMin = m_spatialPartitionTree->GetMin();
+	const float* simulationMax = m_spatialPartitionTree->GetMax();
+
+	// Destruction is queued, so the object list doesn't change under the loop
+	for (size_t i = 0; i < m_bodies.Size(); ++i) {
+		float objPos[3] = { m_bodies.pos[i].x, m_bodies.pos[i].y, m_bodies.pos[i].z };
+
+		if (!AABB::PointInMinMax(objPos, simulationMin, simulationMax)) {
+			DestroyObject(m_objects[i]);
+		}
+	}
+}
+
+/**
+*	@brief Auto selection, periodically run every broadphase for a few steps and switch to whichever found pairs the quickest.
+*	Sampling uses the real steps (every broadphase finds the same pairs) so it costs nothing beyond the slower broadphases being slower.
+*	NOTE: A broadphase that sat idle has to catch up with everything that moved on its first step, so that step is not counted.
+*	NOTE: The octree is timed rebuilding its tree and finding pairs, the same work a persistent broadphase is timed refitting and finding pairs for.
+*	@return void.
+*/
+void Scene::UpdateAutoBroadphase()
+{
+	++m_autoStep;
+
+	/// Settled on a broadphase, start sampling again once the interval is up (the scene may have changed)
+	if (m_autoCandidate == BROADPHASE_COUNT) {
+		if (m_autoStep >= BROADPHASE_AUTO_INTERVAL) {
+			m_autoStep		= 0;
+			m_autoTimeSum	= 0.f;
+			m_autoCandidate = NextAutoCandidate(-1);
+			m_broadphase	= (eBroadphase)m_autoCandidate;
+		}
+
+		return;
+	}
+
+	/// Sampling, time the candidate until it has run enough steps
+	if (m_autoStep > 1) {
+		m_autoTimeSum += m_broadphaseTimes[m_autoCandidate];
+	}
+
+	if (m_autoStep < BROADPHASE_AUTO_SAMPLE_STEPS) {
+		return;
+	}
+
+	m_broadphaseTimes[m_autoCandidate] = m_autoTimeSum / (BROADPHASE_AUTO_SAMPLE_STEPS - 1);
+
+	m_autoStep		= 0;
+	m_autoTimeSum	= 0.f;
+	m_autoCandidate = NextAutoCandidate(m_autoCandidate);
+
+	if (m_autoCandidate != BROADPHASE_COUNT) {
+		m_broadphase = (eBroadphase)m_autoCandidate;
+		return;
+	}
+
+	/// Every candidate sampled, settle on the cheapest
+	int cheapest = NextAutoCandidate(-1);
+
+	for (int i = NextAutoCandidate(cheapest); i != BROADPHASE_COUNT; i = NextAutoCandidate(i)) {
+		if (m_broadphaseTimes[i] < m_broadphaseTimes[cheapest]) {
+			cheapest = i;
+		}
+	}
+
+	m_broadphase = (eBroadphase)cheapest;
+}
+
+/**
+*	@brief Find the next broadphase auto selection can sample.
+*	NOTE: Brute force is skipped when there are too many objects for it to run a single step without stalling the scene.
+*	NOTE: The octree is rebuilt every step so has no persistent broadphase, but is still sampled.
+*	@param a_after is the broadphase to search on from, -1 to start from the first.
+*	@return Next broadphase to sample, BROADPHASE_COUNT if there are none left.
+*/
+int Scene::NextAutoCandidate(int a_after) const
+{
+	for (int i = a_after + 1; i < BROADPHASE_COUNT; ++i) {
+		if (m_broadphases[i] == nullptr && i != OCTREE) {
+			continue;
 		}
 
+		if (i == BRUTE_FORCE && m_objects.size() > BROADPHASE_AUTO_BRUTE_FORCE_LIMIT) {
+			continue;
+		}
+
+		return i;
 	}
 
-	// Traverse created volumes and use callback class to detect collisions only with objects contained in the volume
-	OctreeCallbackDetectCollisions collBack;		// Puns are great, shhh
-	m_spatialPartitionTree->traverse(&collBack);
+	return BROADPHASE_COUNT;
 }
 
 /**
@@ -800,7 +1619,7 @@ bool Scene::IsColliding_Plane_AABB(Collision& a_collision) {
 	if (closestCornerDist <= 0) {
 
 		// Overlap is the straight distance between plane and closest corner (abs because overlap can never be negative)
-		a_collision.overlap = abs(closestCornerDist);
+		a_collision.overlap = std::abs(closestCornerDist);
 
 		// Collision normal determined by what side of the plane AABB is on
 		a_collision.collisionNormal = planeNormal;
@@ -893,22 +1712,23 @@ bool Scene::IsColliding_AABB_AABB(Collision & a_collision)
 		/// THIS METHOD WORKS FOR ANY KIND OF COLLISION SCENARIO
 		// Calculate overlap between AABBs by minusing distance between AABBs from the total overlap volume
 		// B - A to get vector between objects for consistency
-		glm::vec3 betweenVec			= glm::abs(otherAABB->GetPos() - actorAABB->GetPos());
+		glm::vec3 directionVec			= otherAABB->GetPos() - actorAABB->GetPos();
+		glm::vec3 betweenVec			= glm::abs(directionVec);
 		glm::vec3 totalOverlapVolume	= (actorAABB->GetExtents() + otherAABB->GetExtents()) / 2.f;		// Use combined half-extents to get AABB 'radii'
 		glm::vec3 overlapVec			= totalOverlapVolume - betweenVec;									
 
-		// Get collision normal by basing it off the smallest axis of overlap
+		// Get collision normal by basing it off the smallest axis of overlap, pointing from actor to other along it
 		float smallestAxis		= std::min((std::min(overlapVec.x, overlapVec.y)), overlapVec.z);
 		glm::vec3 collNormal	= glm::vec3();
 
 		if (smallestAxis == overlapVec.x) {
-			collNormal = overlapVec.x < 0 ? glm::vec3(-1, 0, 0) : glm::vec3(1, 0, 0);
+			collNormal = directionVec.x < 0 ? glm::vec3(-1, 0, 0) : glm::vec3(1, 0, 0);
 		}
 		else if (smallestAxis == overlapVec.y) {
-			collNormal = overlapVec.y < 0 ? glm::vec3(0, -1, 0) : glm::vec3(0, 1, 0);
+			collNormal = directionVec.y < 0 ? glm::vec3(0, -1, 0) : glm::vec3(0, 1, 0);
 		}
 		else if (smallestAxis == overlapVec.z) {
-			collNormal = overlapVec.z < 0 ? glm::vec3(0, 0, -1) : glm::vec3(0, 0, 1);
+			collNormal = directionVec.z < 0 ? glm::vec3(0, 0, -1) : glm::vec3(0, 0, 1);
 		}
 
 		a_collision.collisionNormal = collNormal;
@@ -922,268 +1742,798 @@ bool Scene::IsColliding_AABB_AABB(Collision & a_collision)
 
 
 /**
-*	@brief Apply defined gravity force to every object in the scene.
+*	@brief Apply gravity, the pending global force and friction dampening to every dynamic object then integrate their velocity and position with the fixed time step.
+*	NOTE: One fused pass over the body store, SIMD_WIDTH bodies at a time. Acceleration is reset for every object afterwards (regardless of static or dynamic) so it gets re-calculated.
 *	@return void.
 */
-void Scene::ApplyGravity()
+void Scene::IntegrateBodies()
 {
-	for (auto obj : m_objects) {
-		obj->ApplyForce(m_gravity * obj->GetMass());	// Ensure heavier objects have a greater gravity force acting on them
+	glm::vec3 force = m_pendingGlobalForce;
+	m_pendingGlobalForce = glm::vec3();
+
+	// Every body only touches its own slot so the sweep can be split freely across threads
+	m_jobSystem->ParallelFor(m_bodies.Size(), JOB_GRAIN_SIZE, [this, &force](size_t a_begin, size_t a_end, unsigned int) {
+		size_t i = a_begin;
+
+		for (; i + SIMD_WIDTH <= a_end; i += SIMD_WIDTH) {
+			IntegrateBatch(m_bodies, i, m_gravity, force, m_fixedTimeStep);
+		}
+
+		// Leftover bodies that don't fill a batch
+		for (; i < a_end; ++i) {
+			IntegrateBody(m_bodies, i, m_gravity, force, m_fixedTimeStep);
+		}
+	});
+
+	// Planes are positioned by their distance from origin instead of position
+	for (auto plane : m_planes) {
+		plane->UpdateOriginDist(m_fixedTimeStep);
 	}
 }
 
 /**
-*	@brief From a list of objects, check every object against every other object and record collisions for this frame.
-*	@param a_objects is the list of objects to check collisions in.
+*	@brief Check a pair of objects for a collision with the colliding check for their shapes and record it if they are colliding.
+*	NOTE: Only reads scene state so can be called concurrently as long as each call has its own collision list.
+*	@param a_actor is the first object of the pair.
+*	@param a_other is the second object of the pair.
+*	@param a_collisions is the list to add the collision to.
 *	@return void.
 */
-void Scene::DetectCollisions(const std::vector<Rigidbody*>& a_objects)
+void Scene::DetectCollision(Rigidbody * a_actor, Rigidbody * a_other, std::vector<Collision>& a_collisions)
 {
-	// Loop through all objects and check all actor objects against all other objects
-	for (auto actor_iter = a_objects.begin(); actor_iter != a_objects.end(); ++actor_iter) {
-		
-		// Second for loop is shifted one to the right in order to access the 'others'
-		for (auto other_iter = actor_iter + 1; other_iter != a_objects.end(); ++other_iter) {
-			Rigidbody* actor = *actor_iter;
-			Rigidbody* other = *other_iter;
-
-			// For each set of checks, create a temporary collision object to pass into colliding check functions
-			Collision tempCollision(actor, other);
-			
-			#pragma region Object Type Detection and Collision Checks
-			// Determine what kind of object collision we're checking for and detect appropriately
-			switch (actor->GetShape())
-			{
-				case SPHERE:
-				{
-				switch (other->GetShape())
-				{
-					case SPHERE:
-					{
-						if (IsColliding_Sphere_Sphere(tempCollision)) {
-							m_collisions.push_back(tempCollision);
-						}
+	// Create a temporary collision object to pass into the colliding check, the check for each pair of shapes is looked up in a table generated at compile time
+	Collision tempCollision(a_actor, a_other);
 
-						break;
-					}
-					case AA_BOX:
-					{
-						if (IsColliding_Sphere_AABB(tempCollision)) {
-							m_collisions.push_back(tempCollision);
-						}
-						break;
-					}
-					case PLANE:
-					{
-						if (IsColliding_Sphere_Plane(tempCollision)) {
-							m_collisions.push_back(tempCollision);
-						}
+	if (GetShapePairRoute(a_actor->GetShape(), a_other->GetShape()).check(tempCollision)) {
+		a_collisions.push_back(tempCollision);
+	}
+}
 
-						break;
-					}
+/**
+*	@brief Check every pair found by a broadphase, split across threads.
+*	NOTE: Pairs are sorted into a bucket per combination of shapes first, so each bucket is checked by a loop without any shape branches (see CollisionDispatch.h).
+*	NOTE: Collisions are added in the same order as the pairs no matter how many threads ran.
+*	@param a_pairs is the list of pairs to check.
+*	@param a_collisions is the list to add detected collisions to.
+*	@return void.
+*/
+void Scene::DetectPairCollisions(const std::vector<CollisionPair>& a_pairs, std::vector<Collision>& a_collisions)
+{
+	for (auto& bucket : m_pairBuckets) {
+		bucket.clear();
+	}
+
+	m_pairCollisions.resize(a_pairs.size(), Collision(nullptr, nullptr));
+
+	/// 1. Sort pairs into buckets, swapping them into the order the bucket's check expects
+	for (size_t i = 0; i < a_pairs.size(); ++i) {
+		const CollisionPair&	pair	= a_pairs[i];
+		const ShapePairRoute&	route	= GetShapePairRoute(pair.actor->GetShape(), pair.other->GetShape());
+
+		// Shapes can't collide or neither object is moving (static or asleep), mark the pair's result as empty
+		if (route.bucket == -1 || (!pair.actor->GetIsActive() && !pair.other->GetIsActive())) {
+			m_pairCollisions[i].actor = nullptr;
+
+			continue;
+		}
+
+		if (!route.b_swap) {
+			m_pairBuckets[route.bucket].push_back(BucketPair{ pair.actor, pair.other, (unsigned int)i });
+		}
+		else {
+			m_pairBuckets[route.bucket].push_back(BucketPair{ pair.other, pair.actor, (unsigned int)i });
+		}
+	}
+
+	/// 2. Check each bucket with its own colliding check, results go in the pair's slot
+	DetectBucketCollisions(std::make_index_sequence<SHAPE_COUNT * SHAPE_COUNT>());
+
+	/// 3. Gather the collisions back in pair order
+	for (auto& collision : m_pairCollisions) {
+		if (collision.actor != nullptr) {
+			a_collisions.push_back(collision);
+		}
+	}
+}
+
+/**
+*	@brief Check the pairs in every bucket.
+*	NOTE: Expands to a call per combination of shapes, buckets of combinations without a colliding check in that order are always empty.
+*	@return void.
+*/
+template <size_t... Buckets>
+void Scene::DetectBucketCollisions(std::index_sequence<Buckets...>)
+{
+	int expand[] = { 0, (DetectBucketCollisions<(eShape)(Buckets / SHAPE_COUNT), (eShape)(Buckets % SHAPE_COUNT)>(), 0)... };
+	(void)expand;
+}
+
+/**
+*	@brief Check every pair in a bucket, split across threads.
+*	NOTE: Pairs are run through the shapes' batch kernel PAIR_BATCH_WIDTH at a time, only the ones it passes get the (exact) colliding check.
+*	NOTE: Each pair writes its result to its own slot in the pair collisions, a null actor if it wasn't colliding.
+*	@return void.
+*/
+template <eShape Actor, eShape Other>
+void Scene::DetectBucketCollisions()
+{
+	typedef ShapePairDispatch<Actor, Other> Dispatch;
+
+	const std::vector<BucketPair>& bucket = m_pairBuckets[Actor * SHAPE_COUNT + Other];
+
+	if (bucket.empty()) {
+		return;
+	}
+
+	m_jobSystem->ParallelFor(bucket.size(), PAIR_GRAIN_SIZE, [this, &bucket](size_t a_begin, size_t a_end, unsigned int) {
+		for (size_t first = a_begin; first < a_end; first += PAIR_BATCH_WIDTH) {
+			size_t	count	= std::min((size_t)PAIR_BATCH_WIDTH, a_end - first);
+			int		mask	= Dispatch::BatchMask(&bucket[first], count);
+
+			for (size_t lane = 0; lane < count; ++lane) {
+				const BucketPair&	pair		= bucket[first + lane];
+				Collision&			collision	= m_pairCollisions[pair.pairIndex];
+
+				collision = Collision(pair.actor, pair.other);
+
+				if (!(mask & (1 << lane)) || !Dispatch::Check(collision)) {
+					collision.actor = nullptr;
 				}
-				break;
+			}
+		}
+	});
+}
+
+/**
+*	@brief Check a batch of sphere pairs at once by comparing squared distances between their positions with their squared combined radii, no square roots needed.
+*	NOTE: Pairs within NARROWPHASE_SLACK of touching pass too, IsColliding_Sphere_Sphere makes the final decision and works out the normal and overlap.
+*	@param a_pairs is the first pair of the batch.
+*	@param a_count is how many pairs are in the batch, up to PAIR_BATCH_WIDTH.
+*	@return Bit mask of the pairs that could be colliding, bit 0 is the first pair.
+*/
+int Scene::SphereSphereBatchMask(const BucketPair * a_pairs, size_t a_count)
+{
+	// Gather the batch side by side, unused lanes are left at 0 and masked out at the end
+	alignas(32) float actorX[PAIR_BATCH_WIDTH] = {}, actorY[PAIR_BATCH_WIDTH] = {}, actorZ[PAIR_BATCH_WIDTH] = {}, actorRadius[PAIR_BATCH_WIDTH] = {};
+	alignas(32) float otherX[PAIR_BATCH_WIDTH] = {}, otherY[PAIR_BATCH_WIDTH] = {}, otherZ[PAIR_BATCH_WIDTH] = {}, otherRadius[PAIR_BATCH_WIDTH] = {};
+
+	for (size_t lane = 0; lane < a_count; ++lane) {
+		const glm::vec3& actorPos = a_pairs[lane].actor->GetPos();
+		const glm::vec3& otherPos = a_pairs[lane].other->GetPos();
+
+		actorX[lane]		= actorPos.x;
+		actorY[lane]		= actorPos.y;
+		actorZ[lane]		= actorPos.z;
+		actorRadius[lane]	= static_cast<Sphere*>(a_pairs[lane].actor)->GetRadius();
+
+		otherX[lane]		= otherPos.x;
+		otherY[lane]		= otherPos.y;
+		otherZ[lane]		= otherPos.z;
+		otherRadius[lane]	= static_cast<Sphere*>(a_pairs[lane].other)->GetRadius();
+	}
+
+	int mask = 0;
+
+#if PHYSEBS_AVX
+	__m256 diffX	= _mm256_sub_ps(_mm256_load_ps(otherX), _mm256_load_ps(actorX));
+	__m256 diffY	= _mm256_sub_ps(_mm256_load_ps(otherY), _mm256_load_ps(actorY));
+	__m256 diffZ	= _mm256_sub_ps(_mm256_load_ps(otherZ), _mm256_load_ps(actorZ));
+	__m256 distSq	= _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(diffX, diffX), _mm256_mul_ps(diffY, diffY)), _mm256_mul_ps(diffZ, diffZ));
+	__m256 reach	= _mm256_add_ps(_mm256_add_ps(_mm256_load_ps(actorRadius), _mm256_load_ps(otherRadius)), _mm256_set1_ps(NARROWPHASE_SLACK));
+
+	mask = _mm256_movemask_ps(_mm256_cmp_ps(distSq, _mm256_mul_ps(reach, reach), _CMP_LE_OQ));
+#elif PHYSEBS_SSE
+	__m128 diffX	= _mm_sub_ps(_mm_load_ps(otherX), _mm_load_ps(actorX));
+	__m128 diffY	= _mm_sub_ps(_mm_load_ps(otherY), _mm_load_ps(actorY));
+	__m128 diffZ	= _mm_sub_ps(_mm_load_ps(otherZ), _mm_load_ps(actorZ));
+	__m128 distSq	= _mm_add_ps(_mm_add_ps(_mm_mul_ps(diffX, diffX), _mm_mul_ps(diffY, diffY)), _mm_mul_ps(diffZ, diffZ));
+	__m128 reach	= _mm_add_ps(_mm_add_ps(_mm_load_ps(actorRadius), _mm_load_ps(otherRadius)), _mm_set1_ps(NARROWPHASE_SLACK));
+
+	mask = _mm_movemask_ps(_mm_cmple_ps(distSq, _mm_mul_ps(reach, reach)));
+#else
+	for (int lane = 0; lane < PAIR_BATCH_WIDTH; ++lane) {
+		float diffX		= otherX[lane] - actorX[lane];
+		float diffY		= otherY[lane] - actorY[lane];
+		float diffZ		= otherZ[lane] - actorZ[lane];
+		float reach		= actorRadius[lane] + otherRadius[lane] + NARROWPHASE_SLACK;
+
+		if (diffX * diffX + diffY * diffY + diffZ * diffZ <= reach * reach) {
+			mask |= 1 << lane;
+		}
+	}
+#endif
+
+	return mask & ((1 << a_count) - 1);
+}
+
+/**
+*	@brief Check a batch of box pairs at once by comparing the distance between their positions with their combined half extents on each axis.
+*	NOTE: Pairs within NARROWPHASE_SLACK of touching pass too, IsColliding_AABB_AABB makes the final decision and works out the normal and overlap.
+*	@param a_pairs is the first pair of the batch.
+*	@param a_count is how many pairs are in the batch, up to PAIR_BATCH_WIDTH.
+*	@return Bit mask of the pairs that could be colliding, bit 0 is the first pair.
+*/
+int Scene::BoxBoxBatchMask(const BucketPair * a_pairs, size_t a_count)
+{
+	// Gather the distance between the boxes and their combined half extents side by side, unused lanes are left at 0 and masked out at the end
+	alignas(32) float diffX[PAIR_BATCH_WIDTH] = {}, diffY[PAIR_BATCH_WIDTH] = {}, diffZ[PAIR_BATCH_WIDTH] = {};
+	alignas(32) float reachX[PAIR_BATCH_WIDTH] = {}, reachY[PAIR_BATCH_WIDTH] = {}, reachZ[PAIR_BATCH_WIDTH] = {};
+
+	for (size_t lane = 0; lane < a_count; ++lane) {
+		const AABB* actorAABB = static_cast<AABB*>(a_pairs[lane].actor);
+		const AABB* otherAABB = static_cast<AABB*>(a_pairs[lane].other);
+
+		glm::vec3 diff	= otherAABB->GetPos() - actorAABB->GetPos();
+		glm::vec3 reach = (actorAABB->GetExtents() + otherAABB->GetExtents()) / 2.f;
+
+		diffX[lane]		= diff.x;
+		diffY[lane]		= diff.y;
+		diffZ[lane]		= diff.z;
+		reachX[lane]	= reach.x;
+		reachY[lane]	= reach.y;
+		reachZ[lane]	= reach.z;
+	}
+
+	int mask = 0;
+
+#if PHYSEBS_AVX
+	__m256 signBit	= _mm256_set1_ps(-0.f);
+	__m256 slack	= _mm256_set1_ps(NARROWPHASE_SLACK);
+	__m256 overlapX = _mm256_cmp_ps(_mm256_andnot_ps(signBit, _mm256_load_ps(diffX)), _mm256_add_ps(_mm256_load_ps(reachX), slack), _CMP_LE_OQ);
+	__m256 overlapY = _mm256_cmp_ps(_mm256_andnot_ps(signBit, _mm256_load_ps(diffY)), _mm256_add_ps(_mm256_load_ps(reachY), slack), _CMP_LE_OQ);
+	__m256 overlapZ = _mm256_cmp_ps(_mm256_andnot_ps(signBit, _mm256_load_ps(diffZ)), _mm256_add_ps(_mm256_load_ps(reachZ), slack), _CMP_LE_OQ);
+
+	mask = _mm256_movemask_ps(_mm256_and_ps(_mm256_and_ps(overlapX, overlapY), overlapZ));
+#elif PHYSEBS_SSE
+	__m128 signBit	= _mm_set1_ps(-0.f);
+	__m128 slack	= _mm_set1_ps(NARROWPHASE_SLACK);
+	__m128 overlapX = _mm_cmple_ps(_mm_andnot_ps(signBit, _mm_load_ps(diffX)), _mm_add_ps(_mm_load_ps(reachX), slack));
+	__m128 overlapY = _mm_cmple_ps(_mm_andnot_ps(signBit, _mm_load_ps(diffY)), _mm_add_ps(_mm_load_ps(reachY), slack));
+	__m128 overlapZ = _mm_cmple_ps(_mm_andnot_ps(signBit, _mm_load_ps(diffZ)), _mm_add_ps(_mm_load_ps(reachZ), slack));
+
+	mask = _mm_movemask_ps(_mm_and_ps(_mm_and_ps(overlapX, overlapY), overlapZ));
+#else
+	for (int lane = 0; lane < PAIR_BATCH_WIDTH; ++lane) {
+		if (std::abs(diffX[lane]) <= reachX[lane] + NARROWPHASE_SLACK &&
+			std::abs(diffY[lane]) <= reachY[lane] + NARROWPHASE_SLACK &&
+			std::abs(diffZ[lane]) <= reachZ[lane] + NARROWPHASE_SLACK)
+		{
+			mask |= 1 << lane;
+		}
+	}
+#endif
+
+	return mask & ((1 << a_count) - 1);
+}
+
+/**
+*	@brief Check every plane against the non-plane objects that could be touching it, split across threads.
+*	NOTE: Planes are infinite so broadphases leave them out, this checks them once per step instead.
+*	NOTE: Broadphases that support it skip branches entirely on one side of each plane, the objects left are checked in batches and only those near the plane get the exact check.
+*	@param a_broadphase is the broadphase that was just refit, or null to check every object.
+*	@param a_collisions is the list to add detected collisions to.
+*	@return void.
+*/
+void Scene::DetectPlaneCollisions(const Broadphase * a_broadphase, std::vector<Collision>& a_collisions)
+{
+	bool b_culled				= (a_broadphase != nullptr);
+	bool b_gatheredAll			= false;		// Without culling every plane has the same candidates, only gather them once
+	bool b_gatheredActiveOnly	= false;		// Whether the gathered candidates were narrowed down to moving objects
+
+	for (auto plane : m_planes) {
+		const glm::vec3&	normal	= plane->GetNormal();
+		float				dist	= plane->GetDist();
+
+		// A plane that isn't moving (static or asleep) can only be hit by objects that are
+		bool b_activeOnly = !plane->GetIsActive();
+
+		if (b_culled) {
+			m_planeCandidates.objs.clear();
+
+			// A broadphase that can't cull one plane can't cull any of them
+			b_culled = a_broadphase->QueryPlane(normal, dist, m_planeCandidates.objs);
+
+			if (b_culled) {
+				if (b_activeOnly) {
+					std::vector<Rigidbody*>& objs = m_planeCandidates.objs;
+					objs.erase(std::remove_if(objs.begin(), objs.end(), [](Rigidbody* a_obj) { return !a_obj->GetIsActive(); }), objs.end());
 				}
-				case PLANE:
-				{
-					switch (other->GetShape())
-					{
-						case SPHERE:
-						{
-							if (IsColliding_Plane_Sphere(tempCollision)) {
-								m_collisions.push_back(tempCollision);
-							}
-
-							break;
-						}
-						case AA_BOX:
-						{
-							if (IsColliding_Plane_AABB(tempCollision)) {
-								m_collisions.push_back(tempCollision);
-							}
-							break;
-						}
-					}
-					break;
+
+				GatherPlaneCandidates();
+			}
+		}
+
+		if (!b_culled && (!b_gatheredAll || b_gatheredActiveOnly != b_activeOnly)) {
+			m_planeCandidates.objs.clear();
+
+			for (auto obj : m_objects) {
+				if (obj->GetShape() != PLANE && (!b_activeOnly || obj->GetIsActive())) {
+					m_planeCandidates.objs.push_back(obj);
+				}
+			}
+
+			GatherPlaneCandidates();
+			b_gatheredAll			= true;
+			b_gatheredActiveOnly	= b_activeOnly;
+		}
+
+		const PlaneCandidates& candidates = m_planeCandidates;
+
+		m_jobSystem->ParallelForCollect(candidates.x.size() / SIMD_WIDTH, PAIR_GRAIN_SIZE / SIMD_WIDTH, m_threadCollisions, a_collisions, [&](size_t a_batch, std::vector<Collision>& a_found) {
+			size_t first = a_batch * SIMD_WIDTH;
+
+			int mask = PlaneTouchMask(&candidates.x[first], &candidates.y[first], &candidates.z[first], &candidates.radius[first],
+				&candidates.halfX[first], &candidates.halfY[first], &candidates.halfZ[first], normal, dist);
+
+			for (int lane = 0; mask != 0; ++lane, mask >>= 1) {
+				if (mask & 1) {
+					DetectCollision(plane, candidates.objs[first + lane], a_found);
 				}
-				case AA_BOX:
+			}
+		});
+	}
+}
+
+/**
+*	@brief Copy the position and size of every plane candidate into the side by side lists, padding them to a multiple of SIMD_WIDTH.
+*	@return void.
+*/
+void Scene::GatherPlaneCandidates()
+{
+	PlaneCandidates&	candidates	= m_planeCandidates;
+	size_t				count		= candidates.objs.size();
+	size_t				paddedCount	= (count + SIMD_WIDTH - 1) / SIMD_WIDTH * SIMD_WIDTH;
+
+	candidates.x.resize(paddedCount);
+	candidates.y.resize(paddedCount);
+	candidates.z.resize(paddedCount);
+	candidates.radius.resize(paddedCount);
+	candidates.halfX.resize(paddedCount);
+	candidates.halfY.resize(paddedCount);
+	candidates.halfZ.resize(paddedCount);
+
+	m_jobSystem->ParallelFor(paddedCount, JOB_GRAIN_SIZE, [&candidates, count](size_t a_begin, size_t a_end, unsigned int) {
+		for (size_t i = a_begin; i < a_end; ++i) {
+			glm::vec3	pos			= glm::vec3(0);
+			float		radius		= -1.f;				// Padding reaches less than nothing so never touches a plane
+			glm::vec3	halfExtents	= glm::vec3(0);
+
+			if (i < count) {
+				Rigidbody* obj = candidates.objs[i];
+				assert(obj->GetShape() != PLANE && "Planes can't be checked against planes.");
+
+				// Unknown shapes are left as padding so they never touch a plane
+				switch (obj->GetShape())
 				{
-					switch (other->GetShape())
-					{
-						case SPHERE:
-						{
-							if (IsColliding_AABB_Sphere(tempCollision)) {
-								m_collisions.push_back(tempCollision);
-							}
-
-							break;
-						}
-						case AA_BOX:
-						{
-							if (IsColliding_AABB_AABB(tempCollision)) {
-								m_collisions.push_back(tempCollision);
-							}
-							break;
-						}
-						case PLANE:
-						{
-							if (IsColliding_AABB_Plane(tempCollision)) {
-								m_collisions.push_back(tempCollision);
-							}
-							break;
-						}
-					}
+					case SPHERE:
+						pos		= obj->GetPos();
+						radius	= static_cast<Sphere*>(obj)->GetRadius();
+						break;
+					case AA_BOX:
+						pos			= obj->GetPos();
+						radius		= 0.f;
+						halfExtents = static_cast<AABB*>(obj)->GetExtents() / 2.f;
+						break;
+					default:
+						assert(false && "Attempted to check a plane against an object with no plane test for its shape.");
 				}
 			}
+
+			candidates.x[i]		= pos.x;
+			candidates.y[i]		= pos.y;
+			candidates.z[i]		= pos.z;
+			candidates.radius[i] = radius;
+			candidates.halfX[i] = halfExtents.x;
+			candidates.halfY[i] = halfExtents.y;
+			candidates.halfZ[i] = halfExtents.z;
+		}
+	});
+}
+
+/**
+*	@brief Wake sleeping islands hit by an object that is still settling (e.g. a body landing on a resting pile).
+*	NOTE: Objects that have been resting a while are left to push against the sleeping island as if it were static, see UpdateIslands.
+*	@return void.
+*/
+void Scene::WakeTouchedIslands()
+{
+	for (auto& coll : m_collisions) {
+		Rigidbody* sleeper = coll.actor->GetIsAsleep() ? coll.actor : (coll.other->GetIsAsleep() ? coll.other : nullptr);
+
+		if (sleeper == nullptr) {
+			continue;
 		}
-#pragma endregion
 
+		Rigidbody* toucher = (sleeper == coll.actor) ? coll.other : coll.actor;
+
+		if (toucher->GetIsActive() && m_bodies.restTime[toucher->GetStoreIndex()] < SLEEP_TIME) {
+			sleeper->Wake();
+		}
 	}
+}
 
-#pragma region Octal Space Partitioning: Separate Plane Collision Checks
-	if (b_partitionCollisions && m_objects.size() > 1) {			// No point checking collisions if only one object in the scene
-		// Find and store pointers to all planes in the scene
-		std::vector<Rigidbody*> planes;
+/**
+*	@brief Group dynamic objects that touched this step or are constrained together into islands with a union find, then put islands that have come to rest to sleep.
+*	An island sleeps once every awake object in it has moved slower than SLEEP_VELOCITY for SLEEP_TIME, sleeping islands it is resting against are merged into it.
+*	Sleeping objects are skipped by integration, broadphase updates and narrowphase until their island is woken (hit by something settling, a force or being moved).
+*	NOTE: Static objects don't join islands together, otherwise every pile on the same floor would be one island.
+*	@return void.
+*/
+void Scene::UpdateIslands()
+{
+	if (!b_allowSleep) {
+		m_bodies.WakeAll();
+		return;
+	}
 
-		for (auto o : m_objects) {
-			if (o->GetShape() == PLANE) {
-				planes.push_back(o);
+	size_t	count	= m_bodies.Size();
+	float	dt		= m_fixedTimeStep;
+
+	/// 1. Time how long each awake object has been resting
+	m_jobSystem->ParallelFor(count, JOB_GRAIN_SIZE, [this, dt](size_t a_begin, size_t a_end, unsigned int) {
+		for (size_t i = a_begin; i < a_end; ++i) {
+			if (!m_bodies.dynamic[i].value || m_bodies.asleep[i].value) {
+				continue;
+			}
+
+			const glm::vec3& vel = m_bodies.vel[i];
+
+			if (vel.x * vel.x + vel.y * vel.y + vel.z * vel.z < SLEEP_VELOCITY * SLEEP_VELOCITY) {
+				m_bodies.restTime[i] += dt;
+			}
+			else {
+				m_bodies.restTime[i] = 0.f;
 			}
 		}
+	});
 
-		// Check every plane against every other non-plane object
-		for (auto plane : planes) {
+	/// 2. Join objects that touched or are constrained together, sleeping islands weren't checked so are kept together as they were
+	m_islandSets.Reset(count);
 
-			for (auto obj : m_objects) {
-				// Create temporary collision object
-				Collision tempPlaneCollision(plane, obj);
-				
-				// Do not check object if it is a plane
-				if (obj->GetShape() == PLANE) {
+	for (auto& coll : m_collisions) {
+		if (coll.actor->GetIsDynamic() && coll.other->GetIsDynamic()) {
+			m_islandSets.Union(coll.actor->GetStoreIndex(), coll.other->GetStoreIndex());
+		}
+	}
 
-					continue;
-				}
+	for (auto constraint : m_constraints) {
+		if (constraint->GetAttachedActor()->GetIsDynamic() && constraint->GetAttachedOther()->GetIsDynamic()) {
+			m_islandSets.Union(constraint->GetAttachedActor()->GetStoreIndex(), constraint->GetAttachedOther()->GetStoreIndex());
+		}
+	}
 
-				if (obj->GetShape() == SPHERE) {
+	for (auto& members : m_bodies.islands) {
+		for (size_t i = 1; i < members.size(); ++i) {
+			m_islandSets.Union(members[0]->GetStoreIndex(), members[i]->GetStoreIndex());
+		}
+	}
 
-					if (IsColliding_Plane_Sphere(tempPlaneCollision)) {
+	/// 3. Shortest rest time of each island's awake objects, kept by the island's root (-1 if it has no awake objects)
+	m_islandRoots.resize(count);
+	m_islandRest.assign(count, -1.f);
 
-						m_collisions.push_back(tempPlaneCollision);
-					};
-				}
-				if (obj->GetShape() == AA_BOX) {
+	for (unsigned int i = 0; i < count; ++i) {
+		if (!m_bodies.dynamic[i].value) {
+			continue;
+		}
 
-					if (IsColliding_Plane_AABB(tempPlaneCollision)) {
+		m_islandRoots[i] = m_islandSets.Find(i);
 
-						m_collisions.push_back(tempPlaneCollision);
-					}
-				}
-			}
+		if (!m_bodies.asleep[i].value) {
+			float& rest = m_islandRest[m_islandRoots[i]];
+			rest = (rest < 0.f) ? m_bodies.restTime[i] : std::min(rest, m_bodies.restTime[i]);
 		}
+	}
+
+	/// 4. Put islands that have rested long enough to sleep, each island's objects are sorted next to each other
+	m_sleepingBodies.clear();
 
+	for (unsigned int i = 0; i < count; ++i) {
+		if (m_bodies.dynamic[i].value && m_islandRest[m_islandRoots[i]] >= SLEEP_TIME) {
+			m_sleepingBodies.push_back(i);
+		}
 	}
-#pragma endregion
 
+	std::sort(m_sleepingBodies.begin(), m_sleepingBodies.end(), [this](unsigned int a_first, unsigned int a_second) {
+		return m_islandRoots[a_first] != m_islandRoots[a_second] ? m_islandRoots[a_first] < m_islandRoots[a_second] : a_first < a_second;
+	});
+
+	for (size_t first = 0; first < m_sleepingBodies.size();) {
+		size_t last = first + 1;
+
+		while (last < m_sleepingBodies.size() && m_islandRoots[m_sleepingBodies[last]] == m_islandRoots[m_sleepingBodies[first]]) {
+			++last;
+		}
+
+		m_bodies.SleepIsland(&m_sleepingBodies[first], last - first);
+		first = last;
+	}
 }
 
 /**
-*	@brief Apply impulse force to colliding objects to knock them back.
+*	@brief Apply the forces of every spring with the spring kernel, then every other constraint with an awake object.
+*	Other constraints go in batches where no two move the same object so each batch runs across threads.
+*	NOTE: Objects a constraint would wake are woken up front, waking changes the body store's islands so can't happen while a batch is running.
 *	@return void.
 */
-void Scene::ResolveCollisions() {
-	for (auto coll : m_collisions) {
-		/// VECTORS MUST ALWAYS POINT FROM OBJECT A TO OBJECT B (B - A)
-		// Objects are not completely static (collision vec length is not 0)
-		if (glm::length(coll.collisionNormal) != 0) {
-			// Use half of the overlap value (half push-back for each object) to set their position back along the appropriate collision normal so objects are no longer touching
-			glm::vec3 overlapAccountVec = (coll.overlap / 2) * coll.collisionNormal;
+void Scene::UpdateConstraints()
+{
+	UpdateSprings();
 
-			/// DYNAMIC ACTOR, STATIC OTHER
-			if (coll.actor->GetIsDynamic() && !(coll.other->GetIsDynamic())) {
-				// Account for overlap for actor
-				coll.actor->SetPos(coll.actor->GetPos() + (-overlapAccountVec));		// Modifying actor, make overlap vec negative
+	// Every constraint is a spring, nothing left to do
+	if (m_springs.Size() == m_constraints.size()) {
+		return;
+	}
 
-				ApplyKnockback_Static(coll);
-			}
-			/// STATIC ACTOR, DYNAMIC OTHER
-			if (!(coll.actor->GetIsDynamic()) && coll.other->GetIsDynamic()) {
-				// Account for overlap for other
-				coll.other->SetPos(coll.other->GetPos() + overlapAccountVec);
+	/// 1. Wake sleeping objects constrained to awake ones (waking a whole island can bring more constraints into play, so this is done before gathering them)
+	for (auto constraint : m_constraints) {
+		if (constraint->GetType() == SPRING) {
+			continue;
+		}
 
-				ApplyKnockback_Static(coll);
+		Rigidbody* actor = constraint->GetAttachedActor();
+		Rigidbody* other = constraint->GetAttachedOther();
+
+		if (actor->GetIsActive() != other->GetIsActive()) {
+			actor->Wake();
+			other->Wake();
+		}
+	}
+
+	/// 2. Gather the constraints with an object to move, colored by the dynamic objects they move
+	m_activeConstraints.clear();
+	m_constraintBatches.Begin(m_bodies.Size());
+
+	for (auto constraint : m_constraints) {
+		if (constraint->GetType() == SPRING) {
+			continue;
+		}
+
+		Rigidbody* actor = constraint->GetAttachedActor();
+		Rigidbody* other = constraint->GetAttachedOther();
+
+		// Both ends static or asleep, nothing for the constraint to move
+		if (!actor->GetIsActive() && !other->GetIsActive()) {
+			continue;
+		}
+
+		m_activeConstraints.push_back(constraint);
+		m_constraintBatches.Add(actor->GetIsDynamic() ? actor->GetStoreIndex() : BatchColoring::NO_BODY, other->GetIsDynamic() ? other->GetStoreIndex() : BatchColoring::NO_BODY);
+	}
+
+	m_constraintBatches.End();
+
+	/// 3. Constrain a batch at a time
+	SolveBatches(m_jobSystem, m_constraintBatches, [this](unsigned int a_item) {
+		m_activeConstraints[a_item]->Update();
+	});
+}
+
+/**
+*	@brief Apply the forces of every spring, a kernel sweeps the spring store working out each spring's force then every object sums the forces of its springs.
+*	NOTE: Springs are evaluated and objects sum their springs in a fixed order, so the results are the same however many threads ran.
+*	@return void.
+*/
+void Scene::UpdateSprings()
+{
+	if (m_springs.Size() == 0) {
+		return;
+	}
+
+	/// 1. Wake sleeping objects sprung to awake ones (whole islands wake, so springs between two sleeping objects stay asleep together)
+	for (size_t i = 0; i < m_springs.Size(); ++i) {
+		unsigned int actor = m_springs.actor[i];
+		unsigned int other = m_springs.other[i];
+
+		bool b_actorActive = m_bodies.dynamic[actor].value && !m_bodies.asleep[actor].value;
+		bool b_otherActive = m_bodies.dynamic[other].value && !m_bodies.asleep[other].value;
+
+		if (b_actorActive != b_otherActive) {
+			m_objects[actor]->Wake();
+			m_objects[other]->Wake();
+		}
+	}
+
+	/// 2. Work out every spring's force, each spring only writes its own slot
+	m_jobSystem->ParallelFor(m_springs.Size(), JOB_GRAIN_SIZE, [this](size_t a_begin, size_t a_end, unsigned int) {
+		size_t i = a_begin;
+
+		for (; i + SIMD_WIDTH <= a_end; i += SIMD_WIDTH) {
+			SpringForceBatch(m_springs, m_bodies, i);
+		}
+
+		// Leftover springs that don't fill a batch
+		for (; i < a_end; ++i) {
+			SpringForce(m_springs, m_bodies, i);
+		}
+	});
+
+	/// 3. Every awake object adds up the forces of its springs, scaled by its inverse mass once
+	if (m_springs.b_bodySpringsDirty || m_springs.bodyStarts.size() != m_bodies.Size() + 1) {
+		m_springs.BuildBodySprings(m_bodies.Size());
+	}
+
+	m_jobSystem->ParallelFor(m_bodies.Size(), JOB_GRAIN_SIZE, [this](size_t a_begin, size_t a_end, unsigned int) {
+		for (size_t i = a_begin; i < a_end; ++i) {
+			unsigned int first	= m_springs.bodyStarts[i];
+			unsigned int last	= m_springs.bodyStarts[i + 1];
+
+			if (first == last || !m_bodies.dynamic[i].value || m_bodies.asleep[i].value) {
+				continue;
 			}
-			/// DYNAMIC ACTOR, DYNAMIC OTHER
-			if (coll.actor->GetIsDynamic() && coll.other->GetIsDynamic()) {
-				// Account for overlap for actor and other (actor is negative because collisionNormal created from B - A)
-				coll.actor->SetPos(coll.actor->GetPos() + (-overlapAccountVec));
-				coll.other->SetPos(coll.other->GetPos() + overlapAccountVec);
 
-				ApplyKnockback_Dynamic(coll);
+			glm::vec3 force = glm::vec3();
+
+			// Odd ends are the spring's other object, which gets the spring's force, the actor gets the negative
+			for (unsigned int j = first; j < last; ++j) {
+				unsigned int end = m_springs.bodySprings[j];
+
+				if (end & 1) {
+					force += m_springs.force[end >> 1];
+				}
+				else {
+					force -= m_springs.force[end >> 1];
+				}
 			}
+
+			m_bodies.accel[i] += force * m_bodies.invMass[i];
 		}
+	});
+}
 
-		
+/**
+*	@brief Resolve every collision of the step with a sequential impulse solver, then push overlapping objects apart.
+*	Each contact's impulse is accumulated over several passes (the solver iterations) and clamped so contacts only ever push,
+*	passes start from the impulses the same pairs ended the last step with (warm starting) so stacks don't have to converge from nothing every step.
+*	Contacts are solved in batches where no two contacts move the same object, so each batch is split across threads with the same results as solving it serially.
+*	NOTE: Static and sleeping objects are treated as having infinite mass, anything that could disturb sleeping objects has woken them already.
+*	@return void.
+*/
+void Scene::ResolveCollisions() {
+	PrepareContacts();
+
+	SolveBatches(m_jobSystem, m_contactBatches, [this](unsigned int a_item) {
+		ApplyContactImpulse(m_contacts[a_item], m_contacts[a_item].impulse);
+	});
+
+	for (int i = 0; i < m_solverIterations; ++i) {
+		SolveBatches(m_jobSystem, m_contactBatches, [this](unsigned int a_item) {
+			SolveContact(m_contacts[a_item]);
+		});
 	}
 
-	// Collisions have been resolved for this frame, clear all recorded collisions
-	m_collisions.clear();
+	// Keep this step's impulses for the next step to start from, pairs that stopped touching are dropped
+	m_nextContactCache.clear();
+
+	for (auto& contact : m_contacts) {
+		m_nextContactCache[contact.key] = contact.impulse;
+	}
+
+	m_contactCache.swap(m_nextContactCache);
+
+	CorrectContactPositions();
 }
 
 /**
-*	@brief Calculate and apply impulse knockback taking the relative velocity of the two objects into account.
-*	NOTE: Should only be used if both actor and other are dynamic rigidbodies.
-*	@param a_collision is the collision object reference to apply and get possible collision information from.
+*	@brief Turn the step's collisions into solver contacts, working out what each needs from the objects up front.
+*	NOTE: Pairs that can't be pushed (both static or asleep) or without a direction to push in are left out.
+*	Contacts are colored into batches by the objects they move as they're made, static and sleeping objects don't hold a contact back from a batch.
 *	@return void.
 */
-void Scene::ApplyKnockback_Dynamic(Collision& a_collision)
+void Scene::PrepareContacts()
 {
-	// Get average restitution of dynamic objects
-	float restitution = (a_collision.actor->GetRestitution() + a_collision.other->GetRestitution()) / 2.f;
+	m_contacts.clear();
+	m_contactBatches.Begin(m_bodies.Size());
 
-	/// Use collision resolution equation to find scale of impulse knockback force
-	// Modify the ratio of impulse force (MUST USE SAME METHOD AS CALCULATING COLLISION NORMAL: [B - A])
-	glm::vec3 relativeVel = a_collision.other->GetVel() - a_collision.actor->GetVel();
+	for (auto& coll : m_collisions) {
+		/// VECTORS MUST ALWAYS POINT FROM OBJECT A TO OBJECT B (B - A)
+		float normalLength = glm::length(coll.collisionNormal);
+
+		if (normalLength == 0) {
+			continue;
+		}
+
+		bool b_actorActive = coll.actor->GetIsActive();
+		bool b_otherActive = coll.other->GetIsActive();
+
+		if (!b_actorActive && !b_otherActive) {
+			continue;
+		}
+
+		SolverContact contact;
+		contact.actor		= coll.actor->GetStoreIndex();
+		contact.other		= coll.other->GetStoreIndex();
+		contact.normal		= coll.collisionNormal / normalLength;
+		contact.overlap		= coll.overlap;
+		contact.actorInvMass = b_actorActive ? m_bodies.invMass[contact.actor] : 0.f;
+		contact.otherInvMass = b_otherActive ? m_bodies.invMass[contact.other] : 0.f;
+		contact.normalMass	= 1.f / (contact.actorInvMass + contact.otherInvMass);
+
+		// Bounce off using the restitution of the objects that move (averaged if both do), slow contacts don't bounce so resting objects settle
+		float restitution;
+
+		if (b_actorActive && b_otherActive) {
+			restitution = (m_bodies.restitution[contact.actor] + m_bodies.restitution[contact.other]) / 2.f;
+		}
+		else {
+			restitution = b_actorActive ? m_bodies.restitution[contact.actor] : m_bodies.restitution[contact.other];
+		}
 
-	float impulseScale =
-		glm::dot(-(1 + restitution) * relativeVel, a_collision.collisionNormal) /
-		glm::dot(a_collision.collisionNormal, a_collision.collisionNormal * (1 / a_collision.actor->GetMass() + 1 / a_collision.other->GetMass()));
+		float closingVel = glm::dot(m_bodies.vel[contact.other] - m_bodies.vel[contact.actor], contact.normal);
 
-	// Apply impulse resolution force along appropriate direction for each object (assumes collision normal is pointing from actor to other [B - A])
-	a_collision.actor->ApplyImpulseForce(impulseScale * -a_collision.collisionNormal);
-	a_collision.other->ApplyImpulseForce(impulseScale * a_collision.collisionNormal);
+		contact.targetVel = (closingVel < -RESTITUTION_THRESHOLD) ? -restitution * closingVel : 0.f;
+
+		// Same pair of objects either way round, handles stay the same between steps unlike store indices
+		BodyHandle actorHandle = coll.actor->GetHandle();
+		BodyHandle otherHandle = coll.other->GetHandle();
+
+		uint64_t actorKey = (uint64_t)actorHandle.generation << 32 | actorHandle.index;
+		uint64_t otherKey = (uint64_t)otherHandle.generation << 32 | otherHandle.index;
+
+		contact.key = (actorHandle.index < otherHandle.index) ? ContactKey{ actorKey, otherKey } : ContactKey{ otherKey, actorKey };
+
+		auto cached = m_contactCache.find(contact.key);
+		contact.impulse = (cached != m_contactCache.end()) ? cached->second : 0.f;
+
+		m_contacts.push_back(contact);
+		m_contactBatches.Add(b_actorActive ? contact.actor : BatchColoring::NO_BODY, b_otherActive ? contact.other : BatchColoring::NO_BODY);
+	}
+
+	m_contactBatches.End();
 }
 
 /**
-*	@brief Calculate and apply impulse knockback taking only the velocity of the dynamic object
-*	NOTE: Should only be used if one of the rigidbodies are static.
-*	@param a_collision is the collision object reference to apply and get possible collision information from.
+*	@brief Push a contact's objects apart (or together for a negative impulse) along the contact normal.
+*	NOTE: Static and sleeping objects aren't written to at all, other contacts in the same batch can be reading them.
+*	@param a_contact is the contact to apply the impulse to.
+*	@param a_impulse is the size of the impulse, the actor gets the negative.
 *	@return void.
 */
-void Scene::ApplyKnockback_Static(Collision& a_collision)
+void Scene::ApplyContactImpulse(const SolverContact& a_contact, float a_impulse)
 {
-	// For readability create separate pointers that distinguish which object is static and which object is dynamic
-	Rigidbody* staticObj;
-	Rigidbody* dynamicObj;
+	glm::vec3 impulse = a_contact.normal * a_impulse;
 
-	// Assume that there's only one static object
-	if (a_collision.actor->GetIsDynamic()) {
-		dynamicObj	= a_collision.actor;
-		staticObj	= a_collision.other;
+	if (a_contact.actorInvMass != 0) {
+		m_bodies.vel[a_contact.actor] -= impulse * a_contact.actorInvMass;
 	}
-	else {
-		dynamicObj	= a_collision.other;
-		staticObj	= a_collision.actor;
+	if (a_contact.otherInvMass != 0) {
+		m_bodies.vel[a_contact.other] += impulse * a_contact.otherInvMass;
 	}
+}
+
+/**
+*	@brief One solver pass over a contact, adjust its impulse so the objects separate at the target velocity.
+*	NOTE: The contact's total impulse is clamped rather than each change, so a pass can take back what earlier passes overshot but the contact never pulls.
+*	@param a_contact is the contact to solve.
+*	@return void.
+*/
+void Scene::SolveContact(SolverContact& a_contact)
+{
+	float separatingVel = glm::dot(m_bodies.vel[a_contact.other] - m_bodies.vel[a_contact.actor], a_contact.normal);
+
+	float oldImpulse	= a_contact.impulse;
+	a_contact.impulse	= std::max(oldImpulse + (a_contact.targetVel - separatingVel) * a_contact.normalMass, 0.f);
+
+	ApplyContactImpulse(a_contact, a_contact.impulse - oldImpulse);
+}
 
-	// Get restitution of dynamic object
-	float restitution = dynamicObj->GetRestitution();
+/**
+*	@brief Push overlapping objects apart, split between the objects by inverse mass so static and sleeping objects stay put.
+*	NOTE: A little overlap (CONTACT_SLOP) is left so resting contacts stay touching, and found again to warm start from, the next step.
+*	@return void.
+*/
+void Scene::CorrectContactPositions()
+{
+	SolveBatches(m_jobSystem, m_contactBatches, [this](unsigned int a_item) {
+		const SolverContact& contact = m_contacts[a_item];
 
-	// Use collision resolution equation to find impulse knockback force.
-	// NOTE: Because one object is static, assume it has infinite mass and that the relative velocity is the velocity of the dynamic object
-	float impulseScale =
-		glm::dot(-(1 + restitution) * dynamicObj->GetVel(), a_collision.collisionNormal) /
-		(1 / dynamicObj->GetMass());
+		float correction = std::max(contact.overlap - CONTACT_SLOP, 0.f) * POSITION_CORRECTION * contact.normalMass;
 
-	// Apply impulse resolution force along collision normal for dynamic object
-	dynamicObj->ApplyImpulseForce(impulseScale * a_collision.collisionNormal);
+		if (contact.actorInvMass != 0) {
+			m_bodies.pos[contact.actor] -= contact.normal * (correction * contact.actorInvMass);
+		}
+		if (contact.otherInvMass != 0) {
+			m_bodies.pos[contact.other] += contact.normal * (correction * contact.otherInvMass);
+		}
+	});
 }
@@ -0,0 +1,331 @@
+#include "Physics/SpatialHash.h"
+#include "Physics/Rigidbody.h"
+#include "Physics/JobSystem.h"
+#include "Physics/MortonSort.h"
+#include <assert.h>
+#include <algorithm>
+#include <cmath>
+
+using namespace Physebs;
+
+namespace {
+	const uint64_t	EMPTY_KEY		= ~0ull;			// Morton keys only use 63 bits so can never be this
+	const int		CELL_BIAS		= 1 << 20;			// Shifts signed cell coordinates into the 21 unsigned bits each axis gets
+}
+
+SpatialHash::SpatialHash(float a_cellSize) : m_cellSize(a_cellSize)
+{
+	assert(a_cellSize > 0.f && "Spatial hash cell size must be positive.");
+}
+
+/**
+*	@brief Add an object, it gets put in the grid on the next refit.
+*	NOTE: Planes are ignored.
+*	@param a_obj is the object to add.
+*	@return void.
+*/
+void SpatialHash::Insert(Rigidbody * a_obj)
+{
+	if (a_obj->GetShape() == PLANE) {
+		return;
+	}
+
+	assert(m_entryLookup.find(a_obj) == m_entryLookup.end() && "Attempted to add an object to a spatial hash that already holds it.");
+
+	Entry entry;
+	entry.obj			= a_obj;
+	entry.cellMin		= glm::ivec3(0, 0, 0);
+	entry.cellMax		= glm::ivec3(-1, -1, -1);		// Empty range until the next refit
+	entry.b_oversized	= false;
+	a_obj->CalculateBounds(entry.min, entry.max);
+
+	m_entryLookup[a_obj] = (unsigned int)m_entries.size();
+	m_entries.push_back(entry);
+}
+
+/**
+*	@brief Take an object out, does nothing if the grid doesn't hold it (e.g. planes).
+*	NOTE: The grid still holds the old entry indices until the next refit, which must come before finding pairs.
+*	@param a_obj is the object to remove.
+*	@return void.
+*/
+void SpatialHash::Remove(Rigidbody * a_obj)
+{
+	auto foundIter = m_entryLookup.find(a_obj);
+
+	if (foundIter == m_entryLookup.end()) {
+		return;
+	}
+
+	unsigned int index	= foundIter->second;
+	unsigned int last	= (unsigned int)m_entries.size() - 1;
+
+	m_entryLookup.erase(foundIter);
+
+	if (index != last) {
+		m_entries[index]					= m_entries[last];
+		m_entryLookup[m_entries[index].obj] = index;
+	}
+
+	m_entries.pop_back();
+}
+
+/**
+*	@brief Remove every object.
+*	@return void.
+*/
+void SpatialHash::Clear()
+{
+	m_entries.clear();
+	m_entryLookup.clear();
+
+	for (auto& slot : m_table) {
+		slot.key = EMPTY_KEY;
+	}
+	m_cellEntries.clear();
+
+	m_occupiedCellCount = 0;
+}
+
+/**
+*	@brief Refresh the bounds of every object and rebuild the grid, reusing the table and cell lists.
+*	NOTE: Bounds are refreshed in parallel, the grid is then filled as a counting sort (count per cell, prefix sum, scatter).
+*	@param a_jobSystem is the job system to split the bounds refresh across.
+*	@param a_skipAsleep is whether sleeping objects can be skipped, they haven't moved since the last refit.
+*	@return void.
+*/
+void SpatialHash::Refit(JobSystem * a_jobSystem, bool a_skipAsleep)
+{
+	/// 1. Refresh bounds and which cells they touch
+	a_jobSystem->ParallelFor(m_entries.size(), JOB_GRAIN_SIZE, [this, a_skipAsleep](size_t a_begin, size_t a_end, unsigned int) {
+		for (size_t i = a_begin; i < a_end; ++i) {
+			Entry& entry = m_entries[i];
+
+			// Cells touched are kept from the last refit too
+			if (a_skipAsleep && entry.obj->GetIsAsleep()) {
+				continue;
+			}
+
+			entry.obj->CalculateBounds(entry.min, entry.max);
+
+			entry.cellMin = glm::ivec3((int)std::floor(entry.min.x / m_cellSize), (int)std::floor(entry.min.y / m_cellSize), (int)std::floor(entry.min.z / m_cellSize));
+			entry.cellMax = glm::ivec3((int)std::floor(entry.max.x / m_cellSize), (int)std::floor(entry.max.y / m_cellSize), (int)std::floor(entry.max.z / m_cellSize));
+
+			// Use floats so huge objects can't overflow the count
+			float cellCount =
+				((float)entry.cellMax.x - entry.cellMin.x + 1) *
+				((float)entry.cellMax.y - entry.cellMin.y + 1) *
+				((float)entry.cellMax.z - entry.cellMin.z + 1);
+
+			entry.b_oversized = cellCount > SPATIAL_HASH_MAX_OBJECT_CELLS;
+		}
+	});
+
+	/// 2. Size the table for the number of cell references, only ever growing so memory is reused
+	size_t cellReferences = 0;
+
+	for (auto& entry : m_entries) {
+		if (entry.b_oversized) {
+			continue;
+		}
+
+		cellReferences += (entry.cellMax.x - entry.cellMin.x + 1) * (entry.cellMax.y - entry.cellMin.y + 1) * (entry.cellMax.z - entry.cellMin.z + 1);
+	}
+
+	size_t tableSize = m_table.empty() ? 64 : m_table.size();
+
+	while (tableSize < cellReferences * 2) {
+		tableSize *= 2;
+	}
+
+	if (tableSize != m_table.size()) {
+		m_table.resize(tableSize);
+
+		m_tableShift = 64;
+		for (size_t size = tableSize; size > 1; size >>= 1) {
+			--m_tableShift;
+		}
+	}
+
+	for (auto& slot : m_table) {
+		slot.key	= EMPTY_KEY;
+		slot.count	= 0;
+	}
+
+	/// 3. Count the objects in each cell
+	m_occupiedCellCount = 0;
+
+	for (auto& entry : m_entries) {
+		if (entry.b_oversized) {
+			continue;
+		}
+
+		for (int z = entry.cellMin.z; z <= entry.cellMax.z; ++z) {
+			for (int y = entry.cellMin.y; y <= entry.cellMax.y; ++y) {
+				for (int x = entry.cellMin.x; x <= entry.cellMax.x; ++x) {
+					FindOrAddSlot(CellKey(x, y, z)).count++;
+				}
+			}
+		}
+	}
+
+	/// 4. Turn counts into where each cell's objects start
+	unsigned int offset = 0;
+
+	for (auto& slot : m_table) {
+		if (slot.key != EMPTY_KEY) {
+			slot.begin	= offset;
+			offset		+= slot.count;
+			slot.count	= 0;
+		}
+	}
+
+	/// 5. Scatter entries into their cells (in entry order within each cell)
+	m_cellEntries.resize(offset);
+
+	for (unsigned int i = 0; i < m_entries.size(); ++i) {
+		const Entry& entry = m_entries[i];
+
+		if (entry.b_oversized) {
+			continue;
+		}
+
+		for (int z = entry.cellMin.z; z <= entry.cellMax.z; ++z) {
+			for (int y = entry.cellMin.y; y <= entry.cellMax.y; ++y) {
+				for (int x = entry.cellMin.x; x <= entry.cellMax.x; ++x) {
+					Slot& slot = m_table[FindSlot(CellKey(x, y, z))];
+
+					m_cellEntries[slot.begin + slot.count++] = i;
+				}
+			}
+		}
+	}
+}
+
+/**
+*	@brief Find every pair of objects with overlapping bounds, each pair is only output once.
+*	NOTE: Uses the grid from the last refit.
+*	@param a_jobSystem is the job system to split the queries across.
+*	@param a_pairs is the list to add found pairs to.
+*	@return void.
+*/
+void SpatialHash::FindPairs(JobSystem * a_jobSystem, std::vector<CollisionPair>& a_pairs)
+{
+	a_jobSystem->ParallelForCollect(m_entries.size(), PAIR_GRAIN_SIZE, m_threadPairs, a_pairs, [this](size_t a_index, std::vector<CollisionPair>& a_found) {
+		const Entry& entry = m_entries[a_index];
+
+		// Static and sleeping objects in the grid are found by the moving objects they touch instead
+		if (!entry.b_oversized && !entry.obj->GetIsActive()) {
+			return;
+		}
+
+		/// Oversized objects check everything (other oversized objects only once, from the lower index)
+		if (entry.b_oversized) {
+			for (unsigned int i = 0; i < m_entries.size(); ++i) {
+				const Entry& other = m_entries[i];
+
+				if (i == a_index || (other.b_oversized && i < a_index)) {
+					continue;
+				}
+
+				if (entry.min.x <= other.max.x && entry.max.x >= other.min.x &&
+					entry.min.y <= other.max.y && entry.max.y >= other.min.y &&
+					entry.min.z <= other.max.z && entry.max.z >= other.min.z)
+				{
+					a_found.push_back(CollisionPair{ entry.obj, other.obj });
+				}
+			}
+
+			return;
+		}
+
+		/// Check objects sharing a cell with a higher entry index, or that are static or asleep
+		for (int z = entry.cellMin.z; z <= entry.cellMax.z; ++z) {
+			for (int y = entry.cellMin.y; y <= entry.cellMax.y; ++y) {
+				for (int x = entry.cellMin.x; x <= entry.cellMax.x; ++x) {
+					const Slot& slot = m_table[FindSlot(CellKey(x, y, z))];
+
+					for (unsigned int i = slot.begin; i < slot.begin + slot.count; ++i) {
+						unsigned int otherIndex = m_cellEntries[i];
+						const Entry& other		= m_entries[otherIndex];
+
+						if (otherIndex == a_index || (otherIndex < a_index && other.obj->GetIsActive())) {
+							continue;
+						}
+
+						// Objects can share several cells, only output the pair from the cell holding the minimum corner of their overlap
+						if (x != std::max(entry.cellMin.x, other.cellMin.x) ||
+							y != std::max(entry.cellMin.y, other.cellMin.y) ||
+							z != std::max(entry.cellMin.z, other.cellMin.z)) {
+							continue;
+						}
+
+						if (entry.min.x <= other.max.x && entry.max.x >= other.min.x &&
+							entry.min.y <= other.max.y && entry.max.y >= other.min.y &&
+							entry.min.z <= other.max.z && entry.max.z >= other.min.z)
+						{
+							a_found.push_back(CollisionPair{ entry.obj, other.obj });
+						}
+					}
+				}
+			}
+		}
+	});
+}
+
+/**
+*	@brief Interleave the bits of the cell coordinates into a Morton code so nearby cells get nearby keys.
+*	NOTE: Each axis gets 21 bits, coordinates further than 2^20 cells from the origin wrap around (sharing a key only costs extra bounds checks).
+*	@param a_x is the cell's x coordinate.
+*	@param a_y is the cell's y coordinate.
+*	@param a_z is the cell's z coordinate.
+*	@return Morton key of the cell.
+*/
+uint64_t SpatialHash::CellKey(int a_x, int a_y, int a_z)
+{
+	return MortonEncode((uint32_t)(a_x + CELL_BIAS), (uint32_t)(a_y + CELL_BIAS), (uint32_t)(a_z + CELL_BIAS));
+}
+
+/**
+*	@brief Find the table slot of an occupied cell.
+*	@param a_key is the Morton key of the cell.
+*	@return Index of the slot, the cell must be occupied.
+*/
+unsigned int SpatialHash::FindSlot(uint64_t a_key) const
+{
+	size_t mask = m_table.size() - 1;
+	size_t slot = (size_t)((a_key * 0x9E3779B97F4A7C15ull) >> m_tableShift);
+
+	while (m_table[slot].key != a_key) {
+		assert(m_table[slot].key != EMPTY_KEY && "Looked up a cell that is not in the spatial hash.");
+
+		slot = (slot + 1) & mask;
+	}
+
+	return (unsigned int)slot;
+}
+
+/**
+*	@brief Find the table slot of a cell, claiming a free one if the cell isn't occupied yet.
+*	@param a_key is the Morton key of the cell.
+*	@return Slot of the cell.
+*/
+SpatialHash::Slot& SpatialHash::FindOrAddSlot(uint64_t a_key)
+{
+	size_t mask = m_table.size() - 1;
+	size_t slot = (size_t)((a_key * 0x9E3779B97F4A7C15ull) >> m_tableShift);
+
+	// Fibonacci hashing spreads the (very regular) Morton keys, linear probing keeps collisions in the same cache lines
+	while (m_table[slot].key != a_key && m_table[slot].key != EMPTY_KEY) {
+		slot = (slot + 1) & mask;
+	}
+
+	if (m_table[slot].key == EMPTY_KEY) {
+		m_table[slot].key	= a_key;
+		m_table[slot].count = 0;
+
+		++m_occupiedCellCount;
+	}
+
+	return m_table[slot];
+}
@@ -1,5 +1,5 @@
-#include "Physics\Sphere.h"
-#include <Gizmos.h>
+#include "Physics/Sphere.h"
+#include "Physics/DebugDraw.h"
 #include <glm/vec4.hpp>
 
 using namespace Physebs;
@@ -19,8 +19,20 @@ Sphere::~Sphere()
 {
 }
 
-void Sphere::Draw()
+void Sphere::Draw(DebugDraw* a_debugDraw)
 {
 	// Add sphere gizmo for testing
-	aie::Gizmos::addSphere(m_pos, m_radius, m_dimensions.x, m_dimensions.y, m_color);
+	a_debugDraw->AddSphere(GetPos(), m_radius, m_dimensions.x, m_dimensions.y, m_color);
+}
+
+/**
+*	@brief Calculate the box enclosing the sphere.
+*	@param a_min is set to the minimum point of the box.
+*	@param a_max is set to the maximum point of the box.
+*	@return void.
+*/
+void Sphere::CalculateBounds(glm::vec3 & a_min, glm::vec3 & a_max) const
+{
+	a_min = GetPos() - glm::vec3(m_radius);
+	a_max = GetPos() + glm::vec3(m_radius);
 }
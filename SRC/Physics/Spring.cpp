@@ -1,6 +1,6 @@
 #include "Physics/Spring.h"
 #include "Physics/Rigidbody.h"
-#include <Gizmos.h>
+#include "Physics/DebugDraw.h"
 #include <glm/ext.hpp>
 #include <glm/vec3.hpp>
 
@@ -23,13 +23,14 @@ Spring::~Spring()
 
 /**
 *	@brief Calculate and apply spring force for objects based on the length of the spring compared to the resting length.
+*	NOTE: Springs owned by a scene are evaluated by the scene's spring kernel instead, this is kept in step with it.
 *	@return void.
 */
 void Spring::Constrain()
 {
 	// 1. Get difference between target length and current distance between attached rigidbodies
 	glm::vec3	springVec			 = m_attachedOther->GetPos() - m_attachedActor->GetPos();
-	float		currentDisplacement	 = m_restLength - glm::length(springVec);
+	float		currentDisplacement	 = GetRestLength() - glm::length(springVec);
 
 	// 2. Calculate relative velocity depending on type of Rigidbody actor and other are
 	glm::vec3 relativeVel = glm::vec3();
@@ -42,8 +43,8 @@ void Spring::Constrain()
 
 	/// Dynamic vs static
 	if (m_attachedActor->GetIsDynamic() && !m_attachedOther->GetIsDynamic()) {
-		// Other has no velocity so relative velocity is actor's
-		relativeVel = m_attachedActor->GetVel();
+		// Other has no velocity so relative velocity is actor's, negated (B - A)
+		relativeVel = -m_attachedActor->GetVel();
 	}
 
 	/// Static vs dynamic
@@ -53,11 +54,11 @@ void Spring::Constrain()
 	}
 
 	// 3. Determine the scale of how much objects should be sprung back from springiness and disparity between current length and target length
-	float retractScale			= m_springiness * currentDisplacement;
+	float retractScale			= GetSpringiness() * currentDisplacement;
 
 	// 4. Calculate final force to impart on attached Rigidbodies this function call with Hooke's law
 	// NOTE: If constrain condition is not met (not at resting length) then only dampening will be applied.
-	glm::vec3 dampening			= m_springDampening * relativeVel;
+	glm::vec3 dampening			= GetDampening() * relativeVel;
 	
 	glm::vec3 finalSpringForce	= springVec * retractScale - dampening;		// Apply force along spring
 
@@ -74,8 +75,8 @@ void Spring::Constrain()
 
 }
 
-void Spring::Draw()
+void Spring::Draw(DebugDraw* a_debugDraw)
 {
 	// Draw line between attached Rigidbodies to simulate the 'spring'
-	aie::Gizmos::addLine(m_attachedActor->GetPos(), m_attachedOther->GetPos(), m_color);
+	a_debugDraw->AddLine(m_attachedActor->GetPos(), m_attachedOther->GetPos(), m_color);
 }
@@ -0,0 +1,169 @@
+#include "Physics/SpringStore.h"
+#include "Physics/Spring.h"
+#include "Physics/Rigidbody.h"
+#include <assert.h>
+
+using namespace Physebs;
+
+/**
+*	@brief Move a Spring's attributes into a new slot at the end of the store and make the spring a view over it.
+*	NOTE: Both attached objects must already be in the scene's body store.
+*	@param a_spring is the spring to take in.
+*	@return Store index of the new slot.
+*/
+unsigned int SpringStore::Add(Spring * a_spring)
+{
+	assert(a_spring->m_store == nullptr && "Attempted to add a Spring that is already owned by a spring store.");
+
+	unsigned int index = (unsigned int)owners.size();
+
+	actor.push_back(a_spring->GetAttachedActor()->GetStoreIndex());
+	other.push_back(a_spring->GetAttachedOther()->GetStoreIndex());
+
+	springiness.push_back(a_spring->m_springiness);
+	restLength.push_back(a_spring->m_restLength);
+	dampening.push_back(a_spring->m_springDampening);
+
+	force.push_back(glm::vec3());
+
+	owners.push_back(a_spring);
+
+	// Spring now reads and writes through the store
+	a_spring->m_store		= this;
+	a_spring->m_storeIndex	= index;
+
+	b_bodySpringsDirty = true;
+
+	return index;
+}
+
+/**
+*	@brief Copy a Spring's attributes back into the spring and free its slot by moving the last slot into it.
+*	@param a_spring is the spring to give back its attributes.
+*	@return void.
+*/
+void SpringStore::Remove(Spring * a_spring)
+{
+	assert(a_spring->m_store == this && "Attempted to remove a Spring from a spring store that does not own it.");
+
+	unsigned int index	= a_spring->m_storeIndex;
+	unsigned int last	= (unsigned int)owners.size() - 1;
+
+	// Spring keeps its last attributes so it is still valid outside of the scene
+	a_spring->m_springiness		= springiness[index];
+	a_spring->m_restLength		= restLength[index];
+	a_spring->m_springDampening	= dampening[index];
+
+	a_spring->m_store		= nullptr;
+	a_spring->m_storeIndex	= 0;
+
+	// Swap last slot into the hole so arrays stay contiguous, then patch the moved spring's view
+	if (index != last) {
+		actor[index]		= actor[last];
+		other[index]		= other[last];
+		springiness[index]	= springiness[last];
+		restLength[index]	= restLength[last];
+		dampening[index]	= dampening[last];
+		force[index]		= force[last];
+		owners[index]		= owners[last];
+
+		owners[index]->m_storeIndex = index;
+	}
+
+	actor.pop_back();
+	other.pop_back();
+	springiness.pop_back();
+	restLength.pop_back();
+	dampening.pop_back();
+	force.pop_back();
+	owners.pop_back();
+
+	b_bodySpringsDirty = true;
+}
+
+/**
+*	@brief Re-read the body store indices of a spring's attached objects, for when one of them was moved to another slot of its store.
+*	@param a_spring is the spring to update.
+*	@return void.
+*/
+void SpringStore::UpdateBodies(Spring * a_spring)
+{
+	assert(a_spring->m_store == this && "Attempted to update a Spring in a spring store that does not own it.");
+
+	actor[a_spring->m_storeIndex] = a_spring->GetAttachedActor()->GetStoreIndex();
+	other[a_spring->m_storeIndex] = a_spring->GetAttachedOther()->GetStoreIndex();
+
+	b_bodySpringsDirty = true;
+}
+
+/**
+*	@brief Drop every slot without copying attributes back.
+*	NOTE: Only use when the owning springs are about to be deleted.
+*	@return void.
+*/
+void SpringStore::Clear()
+{
+	actor.clear();
+	other.clear();
+	springiness.clear();
+	restLength.clear();
+	dampening.clear();
+	force.clear();
+	owners.clear();
+
+	bodyStarts.clear();
+	bodySprings.clear();
+	b_bodySpringsDirty = true;
+}
+
+/**
+*	@brief Reserve capacity in every array so adding many springs doesn't reallocate.
+*	@param a_count is the total number of springs to make room for.
+*	@return void.
+*/
+void SpringStore::Reserve(size_t a_count)
+{
+	actor.reserve(a_count);
+	other.reserve(a_count);
+	springiness.reserve(a_count);
+	restLength.reserve(a_count);
+	dampening.reserve(a_count);
+	force.reserve(a_count);
+	owners.reserve(a_count);
+}
+
+/**
+*	@brief Group both ends of every spring by the body they're attached to with a counting sort, so each body can sum its springs' forces on its own.
+*	NOTE: Ends are kept in spring order within each body, so the sums come out the same however the bodies are split across threads.
+*	@param a_bodyCount is how many bodies are in the body store.
+*	@return void.
+*/
+void SpringStore::BuildBodySprings(size_t a_bodyCount)
+{
+	bodyStarts.assign(a_bodyCount + 1, 0);
+	bodySprings.resize(owners.size() * 2);
+
+	for (size_t i = 0; i < owners.size(); ++i) {
+		bodyStarts[actor[i] + 1]++;
+		bodyStarts[other[i] + 1]++;
+	}
+
+	for (size_t i = 0; i < a_bodyCount; ++i) {
+		bodyStarts[i + 1] += bodyStarts[i];
+	}
+
+	// Fill using the starts as write cursors, which leaves each one at the start of the next body
+	for (size_t i = 0; i < owners.size(); ++i) {
+		bodySprings[bodyStarts[actor[i]]++] = (unsigned int)i * 2;
+		bodySprings[bodyStarts[other[i]]++] = (unsigned int)i * 2 + 1;
+	}
+
+	// Shift the cursors back to where each body starts
+	for (size_t i = a_bodyCount; i > 0; --i) {
+		bodyStarts[i] = bodyStarts[i - 1];
+	}
+
+	bodyStarts[0] = 0;
+
+	b_bodySpringsDirty = false;
+}
@@ -0,0 +1,218 @@
+#include "Physics/SweepAndPrune.h"
+#include "Physics/Rigidbody.h"
+#include "Physics/JobSystem.h"
+#include <assert.h>
+#include <algorithm>
+
+using namespace Physebs;
+
+SweepAndPrune::SweepAndPrune(unsigned int a_axis) : m_axis(a_axis)
+{
+	assert(a_axis < 3 && "Sweep and prune axis must be 0 (x), 1 (y) or 2 (z).");
+}
+
+/**
+*	@brief Add an object and its interval endpoints, they get sorted into place on the next refit.
+*	NOTE: Planes are ignored.
+*	@param a_obj is the object to add.
+*	@return void.
+*/
+void SweepAndPrune::Insert(Rigidbody * a_obj)
+{
+	if (a_obj->GetShape() == PLANE) {
+		return;
+	}
+
+	assert(m_entryLookup.find(a_obj) == m_entryLookup.end() && "Attempted to add an object to a sweep and prune broadphase that already holds it.");
+
+	unsigned int index = (unsigned int)m_entries.size();
+
+	Entry entry;
+	entry.obj = a_obj;
+	a_obj->CalculateBounds(entry.min, entry.max);
+
+	m_entries.push_back(entry);
+	m_entryLookup[a_obj] = index;
+
+	m_endpoints.push_back(Endpoint{ entry.min[m_axis], index, false });
+	m_endpoints.push_back(Endpoint{ entry.max[m_axis], index, true });
+}
+
+/**
+*	@brief Take an object out, does nothing if the broadphase doesn't hold it (e.g. planes).
+*	NOTE: Amortised O(1), the entry is only marked as removed. Its endpoints are purged by the next refit, which passes over every endpoint anyway,
+*	or once half the entries are removed ones (so they don't pile up while another broadphase is in use).
+*	@param a_obj is the object to remove.
+*	@return void.
+*/
+void SweepAndPrune::Remove(Rigidbody * a_obj)
+{
+	auto foundIter = m_entryLookup.find(a_obj);
+
+	if (foundIter == m_entryLookup.end()) {
+		return;
+	}
+
+	m_entries[foundIter->second].obj = nullptr;
+	m_removedCount++;
+
+	m_entryLookup.erase(foundIter);
+
+	if (m_removedCount * 2 > m_entries.size()) {
+		PurgeRemoved();
+	}
+}
+
+/**
+*	@brief Remove every object.
+*	@return void.
+*/
+void SweepAndPrune::Clear()
+{
+	m_entries.clear();
+	m_endpoints.clear();
+	m_entryLookup.clear();
+
+	m_swapCount		= 0;
+	m_removedCount	= 0;
+}
+
+/**
+*	@brief Refresh the bounds and endpoints of every object and re-sort the endpoints.
+*	NOTE: Bounds are refreshed in parallel, the sort is serial but only does work for endpoints that passed each other.
+*	@param a_jobSystem is the job system to split the bounds refresh across.
+*	@param a_skipAsleep is whether sleeping objects can be skipped, they haven't moved since the last refit.
+*	@return void.
+*/
+void SweepAndPrune::Refit(JobSystem * a_jobSystem, bool a_skipAsleep)
+{
+	if (m_removedCount > 0) {
+		PurgeRemoved();
+	}
+
+	a_jobSystem->ParallelFor(m_entries.size(), JOB_GRAIN_SIZE, [this, a_skipAsleep](size_t a_begin, size_t a_end, unsigned int) {
+		for (size_t i = a_begin; i < a_end; ++i) {
+			if (a_skipAsleep && m_entries[i].obj->GetIsAsleep()) {
+				continue;
+			}
+
+			m_entries[i].obj->CalculateBounds(m_entries[i].min, m_entries[i].max);
+		}
+	});
+
+	a_jobSystem->ParallelFor(m_endpoints.size(), JOB_GRAIN_SIZE, [this](size_t a_begin, size_t a_end, unsigned int) {
+		for (size_t i = a_begin; i < a_end; ++i) {
+			Endpoint&		endpoint	= m_endpoints[i];
+			const Entry&	entry		= m_entries[endpoint.entry];
+
+			endpoint.value = endpoint.b_max ? entry.max[m_axis] : entry.min[m_axis];
+		}
+	});
+
+	SortEndpoints();
+}
+
+/**
+*	@brief Find every pair of objects with overlapping bounds, each pair is only output once.
+*	NOTE: Uses the bounds from the last refit.
+*	@param a_jobSystem is the job system to split the sweep across.
+*	@param a_pairs is the list to add found pairs to.
+*	@return void.
+*/
+void SweepAndPrune::FindPairs(JobSystem * a_jobSystem, std::vector<CollisionPair>& a_pairs)
+{
+	assert(m_removedCount == 0 && "Sweep and prune broadphase must be refit after removing objects before finding pairs.");
+
+	// Every interval independently walks forward to its own end, any interval starting on the way overlaps it on the sweep axis.
+	// Each pair is only found by whichever of the two starts first.
+	a_jobSystem->ParallelForCollect(m_endpoints.size(), PAIR_GRAIN_SIZE, m_threadPairs, a_pairs, [this](size_t a_index, std::vector<CollisionPair>& a_found) {
+		const Endpoint& start = m_endpoints[a_index];
+
+		if (start.b_max) {
+			return;
+		}
+
+		const Entry& entry = m_entries[start.entry];
+
+		for (size_t i = a_index + 1; i < m_endpoints.size(); ++i) {
+			const Endpoint& endpoint = m_endpoints[i];
+
+			if (endpoint.entry == start.entry) {
+				break;
+			}
+
+			if (endpoint.b_max) {
+				continue;
+			}
+
+			// Overlapping on the sweep axis, check the other two
+			const Entry& other = m_entries[endpoint.entry];
+
+			if (entry.min.x <= other.max.x && entry.max.x >= other.min.x &&
+				entry.min.y <= other.max.y && entry.max.y >= other.min.y &&
+				entry.min.z <= other.max.z && entry.max.z >= other.min.z)
+			{
+				a_found.push_back(CollisionPair{ entry.obj, other.obj });
+			}
+		}
+	});
+}
+
+/**
+*	@brief Insertion sort the endpoints by value, starts before ends when equal so touching intervals count as overlapping.
+*	@return void.
+*/
+void SweepAndPrune::SortEndpoints()
+{
+	m_swapCount = 0;
+
+	for (size_t i = 1; i < m_endpoints.size(); ++i) {
+		Endpoint	endpoint	= m_endpoints[i];
+		size_t		j			= i;
+
+		while (j > 0 && (m_endpoints[j - 1].value > endpoint.value || (m_endpoints[j - 1].value == endpoint.value && m_endpoints[j - 1].b_max && !endpoint.b_max))) {
+			m_endpoints[j] = m_endpoints[j - 1];
+			--j;
+		}
+
+		m_endpoints[j] = endpoint;
+		m_swapCount += (unsigned int)(i - j);
+	}
+}
+
+/**
+*	@brief Drop the entries and endpoints of removed objects, moving the remaining entries down to fill the gaps.
+*	NOTE: Endpoints keep their sorted order.
+*	@return void.
+*/
+void SweepAndPrune::PurgeRemoved()
+{
+	m_entryRemap.resize(m_entries.size());
+
+	unsigned int kept = 0;
+
+	for (size_t i = 0; i < m_entries.size(); ++i) {
+		if (m_entries[i].obj == nullptr) {
+			m_entryRemap[i] = ~0u;
+
+			continue;
+		}
+
+		if (i != kept) {
+			m_entries[kept]						= m_entries[i];
+			m_entryLookup[m_entries[kept].obj]	= kept;
+		}
+
+		m_entryRemap[i] = kept++;
+	}
+
+	m_entries.resize(kept);
+
+	m_endpoints.erase(std::remove_if(m_endpoints.begin(), m_endpoints.end(), [this](const Endpoint& a_endpoint) { return m_entryRemap[a_endpoint.entry] == ~0u; }), m_endpoints.end());
+
+	for (auto& endpoint : m_endpoints) {
+		endpoint.entry = m_entryRemap[endpoint.entry];
+	}
+
+	m_removedCount = 0;
+}
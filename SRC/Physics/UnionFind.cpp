@@ -0,0 +1,61 @@
+#include "Physics/UnionFind.h"
+#include <assert.h>
+#include <utility>
+
+using namespace Physebs;
+
+/**
+*	@brief Start over with every index in a set of its own.
+*	@param a_count is how many indices there are.
+*	@return void.
+*/
+void UnionFind::Reset(size_t a_count)
+{
+	m_parents.resize(a_count);
+	m_sizes.resize(a_count);
+
+	for (size_t i = 0; i < a_count; ++i) {
+		m_parents[i]	= (unsigned int)i;
+		m_sizes[i]		= 1;
+	}
+}
+
+/**
+*	@brief Find the root of the set an index is in, pointing every other step of the way at its grandparent.
+*	@param a_index is the index to look up.
+*	@return Root index of the set, the same for every index in it.
+*/
+unsigned int UnionFind::Find(unsigned int a_index)
+{
+	assert(a_index < m_parents.size() && "Attempted to find an index that is not in the union find.");
+
+	while (m_parents[a_index] != a_index) {
+		m_parents[a_index]	= m_parents[m_parents[a_index]];
+		a_index				= m_parents[a_index];
+	}
+
+	return a_index;
+}
+
+/**
+*	@brief Join the sets of two indices, the smaller set is hung under the root of the larger one.
+*	@param a_first is an index in one of the sets.
+*	@param a_second is an index in the other set.
+*	@return void.
+*/
+void UnionFind::Union(unsigned int a_first, unsigned int a_second)
+{
+	unsigned int first	= Find(a_first);
+	unsigned int second = Find(a_second);
+
+	if (first == second) {
+		return;
+	}
+
+	if (m_sizes[first] < m_sizes[second]) {
+		std::swap(first, second);
+	}
+
+	m_parents[second]	= first;
+	m_sizes[first]		+= m_sizes[second];
+}
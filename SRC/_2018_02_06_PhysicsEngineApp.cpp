@@ -8,6 +8,7 @@
 #include "Physics\Scene.h"
 #include "Physics\AABB.h"
 #include "Camera\Camera.h"
+#include "GizmosDebugDraw.h"
 #include "Physics\Spring.h"
 #include "PhysebsUtility_Funcs.h"
 #include <algorithm>
@@ -43,6 +44,8 @@ bool _2018_02_06_PhysicsEngineApp::startup() {
 
 	// Make a scene (ha-ha)
 	m_scene = new Scene();
+	m_debugDraw = new GizmosDebugDraw();
+	m_scene->SetDebugDraw(m_debugDraw);
 	m_scene->SetGlobalForce(glm::vec3(0.f, 0, 0));
 
 #if 0
@@ -59,13 +62,16 @@ bool _2018_02_06_PhysicsEngineApp::startup() {
 
 	static float spacing = 10;
 
+	// Create the whole grid at once
+	std::vector<Sphere*> grid = m_scene->CreateObjects<Sphere>(gridX * gridY, 2.f, DEFAULT_SPHERE, glm::vec3());
+
 	// r x c
 	for (int y = 0; y < gridY; y++) {
 		for (int x = 0; x < gridX; x++) {
-			// Add sphere to current grid spot
+			// Move sphere to current grid spot
 			glm::vec3 currentSpawnPos = glm::vec3(gridStartX + offsetX + (x * spacing), gridStartY + offsetY + (y * spacing), 0);
 
-			m_scene->AddObject(new Sphere(2.f, DEFAULT_SPHERE, currentSpawnPos));
+			grid[y * gridX + x]->SetPos(currentSpawnPos);
 
 
 		}
@@ -111,6 +117,7 @@ void _2018_02_06_PhysicsEngineApp::shutdown() {
 
 	delete m_camera;
 	delete m_scene;
+	delete m_debugDraw;
 	
 	Gizmos::destroy();
 }
@@ -153,11 +160,16 @@ void _2018_02_06_PhysicsEngineApp::update(float deltaTime) {
 	static float	minCellSize[3]			= MIN_VOLUME_SIZE;
 
 	ImGui::SliderFloat("Fixed Time Step", m_scene->GetTimeStepRef(), 0.001f, 1.f);
+	ImGui::SliderInt("Solver Iterations", m_scene->GetSolverIterationsRef(), 1, 32);
 
-	ImGui::Checkbox("Use Octal Space Partitioning", m_scene->GetIsPartitionedRef());
+	// Items must be in the same order as eBroadphase
+	ImGui::Combo("Broadphase", m_scene->GetBroadphaseRef(), "Brute Force\0Octree\0Loose Octree\0Sweep And Prune\0Spatial Hash\0AABB Tree\0\0");
+	ImGui::Checkbox("Auto Select Broadphase", m_scene->GetIsAutoBroadphaseRef());
+	ImGui::Text("Broadphase Time: %.3fms", m_scene->GetBroadphaseTime(m_scene->GetBroadphase()));
+	ImGui::Checkbox("Sleep Resting Objects", m_scene->GetAllowSleepRef());
 
-	// Simulation is using partitioning, show partition options
-	if (*(m_scene->GetIsPartitionedRef())) {		// De-reference to get bool
+	// Simulation is using the octree, show partition options
+	if (m_scene->GetBroadphase() == OCTREE) {
 
 		ImGui::InputFloat3("Simulation Origin", simulationOrigin, 2);
 		ImGui::InputFloat3("Simulation Size", simulationExtents, 2);
@@ -227,7 +239,7 @@ void _2018_02_06_PhysicsEngineApp::update(float deltaTime) {
 			if (ImGui::SmallButton("Spawn Sphere")) {
 				glm::vec2 currentDim = glm::vec2(dim[0], dim[1]);
 
-				m_scene->AddObject(new Sphere(radius, currentDim, currentPos, mass, friction, b_dynamic, currentColor, restitution));
+				m_scene->CreateObject<Sphere>(radius, currentDim, currentPos, mass, friction, b_dynamic, currentColor, restitution);
 				b_createdObj = true;
 			}
 		}
@@ -247,7 +259,7 @@ void _2018_02_06_PhysicsEngineApp::update(float deltaTime) {
 				glm::vec3 currentNormal		= glm::vec3(normal[0], normal[1], normal[2]);
 				glm::vec3 currentPlanePos	= currentNormal * dist;					// Ignore user input for position and create it from normal and distance
 
-				m_scene->AddObject(new Plane(currentNormal, dist, currentPlanePos, mass, friction, b_dynamic, currentColor, restitution));
+				m_scene->CreateObject<Plane>(currentNormal, dist, currentPlanePos, mass, friction, b_dynamic, currentColor, restitution);
 				b_createdObj = true;
 			}
 		}
@@ -266,7 +278,7 @@ void _2018_02_06_PhysicsEngineApp::update(float deltaTime) {
 			aie::Gizmos::addAABB(currentPos, currentExtents / 2.f, currentColor);		// Bootstrap treats AABB extents as half extents
 
 			if (ImGui::SmallButton("Spawn AABB")) {
-				m_scene->AddObject(new AABB(currentExtents, currentPos, mass, friction, b_dynamic, currentColor, restitution));
+				m_scene->CreateObject<AABB>(currentExtents, currentPos, mass, friction, b_dynamic, currentColor, restitution);
 				b_createdObj = true;
 			}
 		}
@@ -311,7 +323,10 @@ void _2018_02_06_PhysicsEngineApp::update(float deltaTime) {
 			ImGui::Text("Universal Rigidbody Variables");
 
 			ImGui::InputFloat3("Current Position", currentObj->GetPosRef(), 2);
-			ImGui::InputFloat("Current Mass", currentObj->GetMassRef(), 1.f, 0.f, 2);
+			float currentMass = currentObj->GetMass();
+			if (ImGui::InputFloat("Current Mass", &currentMass, 1.f, 0.f, 2)) {
+				currentObj->SetMass(currentMass);
+			}
 			ImGui::InputFloat("Current Friction", currentObj->GetFrictRef(), 1.f, 0.f, 2);
 			ImGui::InputFloat("Current Restitution", currentObj->GetRestitutionRef(), 1.f, 0.f, 2);
 			ImGui::ColorEdit4("Current Color", currentObj->GetColorRef());
@@ -365,11 +380,8 @@ void _2018_02_06_PhysicsEngineApp::update(float deltaTime) {
 
 			// User wants to delete selected object
 			if (ImGui::Button("Delete Object")) {
-				// Remove from scene (NOTE: DOES NOT DELETE THE MEMORY)
-				m_scene->RemoveObject(currentObj);
-
-				// Delete object allocated memory
-				delete currentObj;
+				// Remove from scene and free it back into its pool (also destroys any attached constraints)
+				m_scene->DestroyObject(currentObj);
 			}
 
 		}
@@ -512,7 +524,7 @@ void _2018_02_06_PhysicsEngineApp::update(float deltaTime) {
 
 				// User wants to create spring
 				if (ImGui::SmallButton("Attach Spring")) {
-					m_scene->AddConstraint(new Spring(selectedActor, selectedOther, currentColor, springiness, restLength, dampening));
+					m_scene->CreateConstraint<Spring>(selectedActor, selectedOther, currentColor, springiness, restLength, dampening);
 				}
 			}
 		}
@@ -575,10 +587,8 @@ void _2018_02_06_PhysicsEngineApp::update(float deltaTime) {
 
 			// User wants to remove constraint from scene
 			if (ImGui::SmallButton("Delete Constraint")) {
-				m_scene->RemoveConstraint(currentConstraint);
-
-				// Delete dynamically allocated memory to avoid memory leaks
-				delete currentConstraint;
+				// Remove from scene and free it back into its pool
+				m_scene->DestroyConstraint(currentConstraint);
 			}
 		}
 	}